@@ -0,0 +1,68 @@
+#pragma once
+
+#include "thermostat.h"
+
+// Relay-feedback autotune (Astrom-Hagglund).  The heater is switched fully
+// on below the setpoint and fully off above it; the resulting steady
+// oscillation gives the plant's ultimate gain and period, from which PID
+// gains are derived.  Like the thermostat this is pure logic.
+
+// --- Tuning run ---
+#define AUTOTUNE_NOISE_BAND_F 0.5f     // Relay switches this far either side of setpoint
+#define AUTOTUNE_CYCLES 3              // Full oscillations measured (after the first)
+#define AUTOTUNE_TIMEOUT_MS (3UL * 60UL * 60UL * 1000UL)
+#define AUTOTUNE_MAX_SPREAD 0.25f      // Cycle amplitudes must agree within 25%
+
+enum AutotuneState {
+  AUTOTUNE_IDLE,
+  AUTOTUNE_RUNNING,
+  AUTOTUNE_DONE,
+  AUTOTUNE_FAILED
+};
+
+class Autotune {
+public:
+  Autotune();
+
+  void start(float setpointF, unsigned long nowMs);
+  void cancel();
+
+  // Feeds a temperature sample and returns the relay duty (0 or 1) to apply.
+  // Moves to DONE or FAILED on its own.
+  float update(float tempF, unsigned long nowMs);
+
+  AutotuneState getState() const { return state; }
+  int cyclesDone() const { return cycles; }
+
+  // Valid once DONE
+  float ultimateGain() const { return ku; }
+  float ultimatePeriodS() const { return tu; }
+  PidGains gains() const;
+
+private:
+  void finish();
+
+  AutotuneState state;
+  float setpoint;
+  bool relayHigh;
+  unsigned long startMs;
+
+  // Extremes of the current half cycle
+  float minSeen;               // Trough happens while the relay is on
+  float maxSeen;               // Peak happens while the relay is off
+  float trough;
+  bool haveTrough;
+  int offSwitches;
+  unsigned long lastOffMs;
+
+  // Sums over the measured cycles
+  int cycles;
+  float amplitudeSum;
+  float amplitudeMin;
+  float amplitudeMax;
+  int periods;
+  float periodSum;
+
+  float ku;
+  float tu;
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <Arduino.h>
+#include "thermostat.h"
+#include "autotune.h"
+#include "settings.h"
+#include "schedule.h"
+#include "probes.h"
+#include "history.h"
+
+// loop() is the only task that changes the sauna's state.  Everyone else
+// (web handlers, the MQTT bridge) asks for a change by posting a command or
+// a setting edit, and
+// reads the state from a snapshot that loop() publishes after each pass.
+// Snapshots are double-buffered behind a sequence counter, so readers get
+// a consistent copy without a lock and never wait on the writer.
+
+#define COMMAND_QUEUE_LENGTH 8
+#define SETTING_QUEUE_LENGTH 8
+
+enum CommandType : uint8_t {
+  CMD_ON,               // Full-length session, unless a countdown is already set
+  CMD_START,            // Run the countdown already set (menu "Start")
+  CMD_STOP,             // Pause, keeping the remaining time (menu "Stop")
+  CMD_OFF,              // End the session and clear the countdown
+  CMD_ADD_TIME,         // value = minutes (0 = the add time setting), capped at the max time
+  CMD_SETPOINT,         // value = °F, clamped to the setpoint range
+  CMD_AUTOTUNE,
+  CMD_AUTOTUNE_CANCEL,
+  CMD_SCHEDULE_ADD,     // entry = the start to add
+  CMD_SCHEDULE_REMOVE   // value = entry id
+};
+
+enum CommandSource : uint8_t {
+  SOURCE_WEB,
+  SOURCE_MENU,
+  SOURCE_SCHEDULE,
+  SOURCE_MQTT,
+  SOURCE_OTA            // A firmware update starting
+};
+
+struct Command {
+  CommandType type;
+  CommandSource source;
+  float value;
+  ScheduleEntry entry;          // CMD_SCHEDULE_ADD only
+};
+
+// A validated setting edit for loop() to apply and persist
+struct SettingChange {
+  int16_t index;                // See settingDef()
+  char text[SETTING_PWD_LEN];   // The longest setting
+};
+
+// One probe as of the last read
+struct ProbeReading {
+  DeviceAddress address;
+  char name[PROBE_NAME_LEN];
+  float tempF;                  // DEVICE_DISCONNECTED_F on a bad read
+};
+
+// Where a history tier stood; the samples themselves are read from the
+// ring, whose sequence check makes that safe (see history.h)
+struct HistoryTierState {
+  uint32_t written;
+  uint16_t count;
+  uint32_t newestTimeS;
+};
+
+// Everything readers outside loop() may look at, copied by value
+struct ControllerSnapshot {
+  float tempF;                  // Control probe, DEVICE_DISCONNECTED_F on a fault
+  float setpointF;
+  bool saunaOn;
+  bool heaterOn;
+  unsigned long countdownMs;
+  char timeRemaining[8];        // "mm:ss"
+  long etaS;                    // Predicted seconds to setpoint, -1 if unknown
+  float duty;
+  ThermostatMode mode;
+  PidGains gains;
+  AutotuneState autotune;
+  int autotuneCycles;
+  uint8_t sampleBits;
+  unsigned long samplePeriodMs;
+  uint32_t modelUpdates;
+  bool modelConverged;
+  float modelTauS;
+  float modelFullPowerF;
+  float sessionKwh;             // Running session, or the last one once off
+  float todayKwh;
+  float monthKwh;
+  float holdDuty;               // Since the setpoint was reached, -1 before
+  bool idle;                    // Idle power mode
+  ScheduleEntry schedule[SCHEDULE_MAX_ENTRIES];
+  uint32_t scheduleNext[SCHEDULE_MAX_ENTRIES];  // Each entry's next start, 0 = none
+  uint32_t nextStart;           // Soonest of those, 0 = none (or clock not set)
+  int probeCount;
+  bool haveControl;             // A probe holds the bench role; sessions can start
+  ProbeReading probes[MAX_PROBES];
+  HistoryTierState history[HISTORY_TIERS];
+  int32_t heaterWatts;          // Settings the handlers quote
+  int32_t maxTimeMin;
+};
+
+// Creates the command queue.  Call once from setup().
+void controllerBegin();
+
+// Queues a command and wakes loop().  Never blocks; false if the queue is
+// full (or not started).
+bool postCommand(CommandType type, CommandSource source, float value = 0);
+bool postCommand(const Command& command);
+
+// Takes the next queued command (loop() only)
+bool pollCommand(Command& command);
+
+// Validates a setting edit and queues it for loop(), which applies and
+// saves it.  Never blocks; false if invalid or the queue is full.
+bool postSetting(int index, const char* text);
+
+// Takes the next queued setting edit (loop() only)
+bool pollSetting(SettingChange& change);
+
+// Publishes a new snapshot (loop() only)
+void publishSnapshot(const ControllerSnapshot& snapshot);
+
+// Copies the latest snapshot.  Safe from any task.
+void readSnapshot(ControllerSnapshot& snapshot);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <stddef.h>
+
+// The session countdown: the time left and, while the sauna is on, the
+// millis() deadline it counts towards.  Stopped, it just holds a preset.
+// Pure logic, driven by the caller's clock.
+
+class Countdown {
+public:
+  Countdown() : remaining(0), deadline(0) {}
+
+  // Sets the time left without starting it
+  void set(unsigned long ms) { remaining = ms; }
+
+  // Counts the time left down from nowMs.  Call when the session starts.
+  void start(unsigned long nowMs) { deadline = nowMs + remaining; }
+
+  // Adds time, never past capMs, and restarts the deadline from nowMs
+  void add(unsigned long ms, unsigned long capMs, unsigned long nowMs);
+
+  // Recomputes the time left while running; true once it has run out
+  bool update(unsigned long nowMs);
+
+  unsigned long remainingMs() const { return remaining; }
+
+  // Milliseconds until the mm:ss reading next changes
+  unsigned long msToNextSecond() const { return remaining % 1000 + 1; }
+
+  // "mm:ss", rounded down like the display always has been
+  void format(char* buf, size_t len) const;
+
+private:
+  unsigned long remaining;
+  unsigned long deadline;
+};
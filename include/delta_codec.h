@@ -0,0 +1,29 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Compact encoding for history samples (int16 centi-degrees F).  Each
+// sample is stored as the zigzag-encoded difference from the previous
+// valid one, plus one, as an LEB128 varint; a zero byte marks a gap.  At
+// the 1 s tier a steady temperature costs one byte per sample instead of
+// the five or six it takes as JSON text.
+
+#define DELTA_MAX_BYTES 3          // Largest possible encoded sample
+#define DELTA_GAP INT16_MIN        // Same value as HISTORY_NO_SAMPLE
+
+struct DeltaEncoder {
+  int16_t last = 0;                // First sample is a delta from 0
+
+  // Encodes one sample into out; returns the bytes written (1..3)
+  size_t encode(int16_t centiF, uint8_t* out);
+};
+
+// Reads what DeltaEncoder wrote; the web page's decodeHistory() mirrors it
+struct DeltaDecoder {
+  int16_t last = 0;
+
+  // Decodes one sample from in (len bytes available).  Returns the bytes
+  // consumed, or 0 if the input ends mid-sample.
+  size_t decode(const uint8_t* in, size_t len, int16_t& centiF);
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+#include "lcd_frame.h"
+
+// The LCD is owned by a low-priority task.  The controller hands it
+// immutable snapshots and never waits on I2C, so a slow or stuck bus can't
+// hold up the SSR, the sensor or the web handlers.
+
+// --- Task setup ---
+#define DISPLAY_TASK_STACK 3072
+#define DISPLAY_TASK_PRIORITY 1
+#define DISPLAY_TASK_CORE 0
+
+#define LCD_I2C_CLOCK 100000  // PCF8574 spec limit; most backpacks also run at 400000
+
+// Everything the main screen shows, copied by value into the render queue
+struct DisplayState {
+  float tempF;
+  char timeRemaining[8];     // "mm:ss"
+  bool saunaOn;
+  bool isSettingTime;
+  int setMinutes;
+  const char* menuLabel;     // Points at a string literal, never freed
+  int etaMinutes;            // Predicted minutes to setpoint, -1 if unknown
+};
+
+// Initializes the LCD and starts the render task.  Call once from setup().
+void displayBegin();
+
+// Queues a new main-screen snapshot.  Only the latest one is kept.
+void displayUpdate(const DisplayState& state);
+
+// Shows two lines over the main screen for durationMs, or until
+// displayClearOverlay() when durationMs is 0.  Returns immediately.
+void displayOverlay(const char* line1, const char* line2, unsigned long durationMs);
+void displayClearOverlay();
+
+// Backlight and rendering on or off, for the idle power mode.  While off,
+// snapshots are still taken in and the latest one is drawn on waking.
+void displaySetAwake(bool awake);
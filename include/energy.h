@@ -0,0 +1,48 @@
+#pragma once
+
+#include <stdint.h>
+
+// Heater energy, from SSR conduction time at the heater's rated power.
+// The meter is fed the running on-time total (safetyHeaterOnUs()) and
+// splits it into today's and this month's.  Periods are named by keys the
+// caller derives from the local date; a new key starts a new period.
+// On-time while the keys are ENERGY_NO_KEY (clock not set yet) is held
+// aside and credited to whichever day and month the clock first shows,
+// so a restored period that has since ended can't swallow it.
+// Pure logic; energy_store.h keeps the totals across reboots.
+
+#define ENERGY_NO_KEY (-1)
+
+// Conduction time at watts, in kWh
+float energyKwh(uint64_t onUs, float watts);
+
+class EnergyMeter {
+public:
+  EnergyMeter();
+
+  // Carries on from saved totals.  Call before the first update().
+  void restore(int32_t dayKey, uint64_t dayUs, int32_t monthKey, uint64_t monthUs,
+               uint64_t heldUs = 0);
+
+  // Adds the on-time since the last call to the current day and month
+  void update(uint64_t totalOnUs, int32_t dayKey, int32_t monthKey);
+
+  uint64_t dayOnUs() const { return day.onUs; }
+  uint64_t monthOnUs() const { return month.onUs; }
+  uint64_t heldOnUs() const { return heldUs; }   // Not yet in a day or month
+  int32_t dayKey() const { return day.key; }
+  int32_t monthKey() const { return month.key; }
+
+private:
+  struct Period {
+    int32_t key;
+    uint64_t onUs;
+  };
+
+  static void roll(Period& period, int32_t key);
+
+  uint64_t lastTotalUs;
+  uint64_t heldUs;
+  Period day;
+  Period month;
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include "energy.h"
+
+// Today's and this month's heater on-time persisted in NVS, so the totals
+// survive a reboot.  Saved at the end of each session, which is the only
+// time the heater runs.
+
+// Restores saved totals into meter.  Returns false (meter untouched) if none.
+bool loadEnergy(EnergyMeter& meter);
+
+void saveEnergy(const EnergyMeter& meter);
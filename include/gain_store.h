@@ -0,0 +1,10 @@
+#pragma once
+
+#include "thermostat.h"
+
+// PID gains persisted in NVS, so a tuned controller starts up tuned
+
+// Loads saved gains into gains.  Returns false (gains untouched) if none.
+bool loadGains(PidGains& gains);
+
+void saveGains(const PidGains& gains);
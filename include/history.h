@@ -0,0 +1,52 @@
+#pragma once
+
+#include <stdint.h>
+
+// Temperature history in RAM, in three tiers of fixed-size rings:
+//   tier 0: 1 s samples, last 10 min
+//   tier 1: 10 s averages, last 3 h (a full session including heat-up)
+//   tier 2: 1 min averages, last 24 h
+// Samples are int16 centi-degrees F in one contiguous block, about 6 KB in
+// total.  One writer (the control loop) and any number of readers; a
+// reader re-checks the sequence number after each read so a sample
+// overwritten mid-read is reported as missing rather than wrong.
+
+#define HISTORY_TIERS 3
+#define HISTORY_NO_SAMPLE INT16_MIN   // Sensor fault or no data
+
+static const uint16_t HISTORY_CAPACITY[HISTORY_TIERS] = { 600, 1080, 1440 };
+static const uint16_t HISTORY_INTERVAL_S[HISTORY_TIERS] = { 1, 10, 60 };
+#define HISTORY_TOTAL_SAMPLES (600 + 1080 + 1440)
+
+class TempHistory {
+public:
+  TempHistory();
+
+  // Adds the 1 s sample; valid=false records a gap (sensor fault)
+  void add(float tempF, bool valid, uint32_t uptimeS);
+
+  // Total samples ever written to a tier; sequence numbers run from
+  // written - count to written - 1.  A full tier holds capacity - 1, the
+  // last slot being the one the next sample goes into.
+  uint32_t written(int tier) const { return tierWritten[tier]; }
+  uint16_t count(int tier) const;
+
+  // Uptime (s) of the tier's newest sample
+  uint32_t newestTimeS(int tier) const { return tierNewestS[tier]; }
+
+  // Reads sample seq.  Returns false if it isn't (or is no longer) stored.
+  bool read(int tier, uint32_t seq, int16_t& centiF) const;
+
+private:
+  void push(int tier, int16_t centiF, uint32_t uptimeS);
+
+  int16_t samples[HISTORY_TOTAL_SAMPLES];
+  uint16_t offset[HISTORY_TIERS];
+  volatile uint32_t tierWritten[HISTORY_TIERS];
+  uint32_t tierNewestS[HISTORY_TIERS];
+
+  // Running averages feeding the next tier down
+  int32_t sum[HISTORY_TIERS];
+  uint16_t validCount[HISTORY_TIERS];
+  uint16_t pending[HISTORY_TIERS];
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Encoder and push-button input.  Rotation is counted by the PCNT hardware,
+// which interrupts on every count, and the switch raises a GPIO interrupt;
+// a small task woken by either turns them into timestamped, debounced
+// events, so nothing is lost while loop() is busy.  With no press being
+// timed the task sleeps until the next edge.
+
+// --- Task setup ---
+#define INPUT_TASK_STACK 2048
+#define INPUT_TASK_PRIORITY 3       // Above loop() so input is never starved
+#define INPUT_TASK_CORE 1
+#define INPUT_QUEUE_LENGTH 16
+
+// --- Timing ---
+#define INPUT_RETRY_MS 5            // Retry a turn the full queue couldn't take
+#define INPUT_DEBOUNCE_MS 25        // Switch must be stable this long
+#define INPUT_LONG_PRESS_MS 800     // Held at least this long = long press
+#define ENCODER_COUNTS_PER_DETENT 4 // Full-quad counts per click
+#define ENCODER_FILTER 1023         // PCNT glitch filter (APB cycles), so bounce can't storm the ISR
+
+enum InputEventType {
+  INPUT_ROTATE,       // delta holds the detents turned (+ clockwise)
+  INPUT_PRESS,        // Short press, sent on release
+  INPUT_LONG_PRESS    // Sent once while still held
+};
+
+struct InputEvent {
+  InputEventType type;
+  int32_t delta;
+  int64_t timestampUs;  // esp_timer time the input happened
+};
+
+// Sets up the pins, the PCNT unit, the switch ISR and the input task
+void inputBegin(int pinA, int pinB, int pinSwitch);
+
+// Takes the next event without waiting.  Returns false when there are none.
+bool inputPoll(InputEvent& event);
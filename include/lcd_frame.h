@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+#include <LiquidCrystal_I2C.h>
+
+#define LCD_COLS 16
+#define LCD_ROWS 2
+
+// Shadow framebuffer for the 16x2 LCD.  Screens are drawn into a back
+// buffer in RAM and flush() sends only the cells that differ from what the
+// LCD is already showing, so an idle display costs no I2C traffic at all.
+class LcdFrame {
+public:
+  explicit LcdFrame(LiquidCrystal_I2C& lcd);
+
+  // Fills the back buffer with spaces (the LCD itself is untouched)
+  void clear();
+
+  // Draws text into the back buffer, clipped at the end of the row
+  void print(uint8_t col, uint8_t row, const char* text);
+
+  // Draws a single raw character code (e.g. a custom glyph like 0)
+  void putChar(uint8_t col, uint8_t row, uint8_t c);
+
+  // Sends the changed cells to the LCD.  Returns the number of cells written.
+  int flush();
+
+  // Forgets what the LCD shows; call after anything writes to it directly
+  void invalidate();
+
+private:
+  LiquidCrystal_I2C& lcd;
+  uint8_t front[LCD_ROWS][LCD_COLS];   // What the LCD is showing
+  uint8_t back[LCD_ROWS][LCD_COLS];    // What we want it to show
+  bool frontValid;
+};
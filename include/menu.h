@@ -0,0 +1,37 @@
+#pragma once
+
+// The encoder menu on the LCD: rotate scrolls the items, press picks one.
+// "Set" switches to picking the session length, where rotate rolls the
+// minutes and press applies them (long press backs out).  Pure logic; the
+// caller maps input events onto it and acts on what press() returns.
+
+enum MenuAction {
+  MENU_NONE,
+  MENU_SELECTED,     // label() was pressed
+  MENU_TIME_SET      // minutes() chosen
+};
+
+class Menu {
+public:
+  Menu(const char* const* items, int count)
+      : items(items), count(count), index(0), settingTime(false), setMinutes(0) {}
+
+  // Scrolls the items, or rolls the minutes over 0..maxMinutes
+  void rotate(int delta, int maxMinutes);
+  MenuAction press();
+  void longPress() { settingTime = false; }
+
+  // Switches to picking the session length
+  void beginSetTime() { settingTime = true; }
+
+  const char* label() const { return items[index]; }
+  bool isSettingTime() const { return settingTime; }
+  int minutes() const { return setMinutes; }
+
+private:
+  const char* const* items;
+  int count;
+  int index;
+  bool settingTime;
+  int setMinutes;
+};
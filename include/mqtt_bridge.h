@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+#include "notify_rules.h"
+
+// Publishes the sauna's state to an MQTT broker and takes commands from
+// it, with Home Assistant discovery so it shows up as a device there.
+// Runs on its own task; commands go through the same controller queue as
+// the web handlers.  Needs MQTT_HOST (and optionally MQTT_PORT,
+// MQTT_USER, MQTT_PWD) in secrets.h, otherwise it stays off.
+//
+// Topics, with <id> = "sauna_" + the last 3 MAC bytes:
+//   sauna/<id>/state          retained JSON, on change (at most every 2 s)
+//   sauna/<id>/availability   "online" / "offline" (last will)
+//   sauna/<id>/event          {"event":"reached","message":"..."} per notification
+//   sauna/<id>/set/power      "ON" / "OFF"
+//   sauna/<id>/set/setpoint   °F
+//   sauna/<id>/set/addtime    minutes (empty = the add time setting)
+
+// --- Task setup ---
+#define MQTT_TASK_STACK 6144
+#define MQTT_TASK_PRIORITY 1
+#define MQTT_TASK_CORE 0
+
+// --- Timing ---
+#define MQTT_POLL_MS 100
+#define MQTT_MIN_PUBLISH_MS 2000      // Rate limit on state messages
+#define MQTT_REFRESH_MS 300000        // Republish unchanged state this often
+#define MQTT_RETRY_MS 5000            // First reconnect delay, doubled each failure
+#define MQTT_RETRY_MAX_MS 120000
+#define MQTT_BUFFER_SIZE 768          // Largest discovery config
+#define MQTT_EVENT_QUEUE_LENGTH 4     // Notifications waiting for the MQTT task
+
+struct MqttStats {
+  bool enabled;
+  bool connected;
+  unsigned long connects;
+  unsigned long publishes;
+  unsigned long commands;
+};
+
+// Starts the MQTT task.  Call once from setup(); a no-op without MQTT_HOST.
+void mqttBegin();
+
+MqttStats mqttGetStats();
+
+// Queues a notification for sauna/<id>/event.  Returns false (try again
+// later) while the broker is unreachable or the queue is full.
+bool mqttPublishEvent(const NotifyMessage& msg);
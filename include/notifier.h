@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+#include "notify_rules.h"
+
+// Notifications are queued here and handled by one background task on the
+// other core, so the control loop never waits on the network.  The task
+// applies the rules in notify_rules.h (per-sink event lists, coalescing)
+// and fans each message out to the sinks that want it:
+//   Discord   DISCORD_WEBHOOK_URL, honouring 429 Retry-After and the
+//             X-RateLimit headers
+//   MQTT      sauna/<id>/event, when the MQTT bridge is configured
+//   ntfy      NTFY_URL (e.g. "https://ntfy.sh/my-sauna"), optional NTFY_TOKEN
+// Each sink has its own outbox and retry timer, so one being rate limited
+// or down doesn't hold up the others.
+
+// --- Queue tuning ---
+#define NOTIFY_QUEUE_LENGTH 8       // Oldest message is dropped when full
+#define NOTIFY_OUTBOX_LENGTH 6      // Per sink, oldest dropped when full
+#define NOTIFY_MAX_ATTEMPTS 5       // Tries per message before giving up (429s don't count)
+#define NOTIFY_BACKOFF_MS 1000      // First retry delay, doubled on each retry
+#define NOTIFY_BACKOFF_MAX_MS 30000 // Cap on the retry delay
+#define NOTIFY_RETRY_AFTER_MAX_MS 600000  // Longest Retry-After we'll honour
+
+enum NotifySinkId {
+  NOTIFY_SINK_DISCORD,
+  NOTIFY_SINK_MQTT,
+  NOTIFY_SINK_NTFY,
+  NOTIFY_SINK_COUNT
+};
+
+// Creates the queue and starts the sender task.  Call once from setup().
+void notifierBegin();
+
+// Queues a message about event.  Never blocks; returns false only if the
+// notifier has not been started.
+bool sendNotification(NotifyEvent event, const String& message);
+
+// Number of messages dropped because a queue was full or retries ran out
+unsigned long notifierDroppedCount();
+
+// Messages folded into a later one by the coalescing window
+unsigned long notifierCoalescedCount();
+
+// --- Delivery stats, per sink ---
+struct NotifierStats {
+  bool enabled;
+  unsigned long handshakes;   // TLS connections opened (HTTP sinks)
+  unsigned long sent;         // Messages delivered
+  unsigned long avgSendMs;    // Mean time per delivery, handshake included
+  unsigned long dropped;
+  unsigned long rateLimited;  // 429s received
+};
+
+NotifierStats notifierGetStats(NotifySinkId sink);
+const char* notifySinkName(NotifySinkId sink);
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Which notifications go out, and how often.  Every message carries an
+// event; each sink has an event mask (a setting) saying which it wants.
+// Repeats of an event within the coalescing window are merged: the first
+// goes out at once, later ones in the window fold into a single trailing
+// message carrying the latest text and a count.  Safety events skip the
+// window.  Pure logic; the notifier task supplies the clock.
+
+#define NOTIFY_MAX_MESSAGE 160      // Longest message we keep (bytes, incl. null)
+#define NOTIFY_NEVER 0xFFFFFFFFUL   // msUntilDue() with nothing open
+
+enum NotifyEvent {
+  NOTIFY_ON,               // Sauna turned on
+  NOTIFY_OFF,              // ... and off (coalesced with on: latest wins)
+  NOTIFY_REACHED,          // Setpoint reached
+  NOTIFY_MINUTES_LEFT,     // Countdown passed the warning point
+  NOTIFY_OVER_TEMP,        // Safety cutoff for temperature
+  NOTIFY_SENSOR_FAULT,     // Control probe stopped answering
+  NOTIFY_SAFETY,           // Any other safety cutoff
+  NOTIFY_TIME_ADDED,
+  NOTIFY_AUTOTUNE,
+  NOTIFY_SCHEDULE,
+  NOTIFY_EVENT_COUNT
+};
+
+#define NOTIFY_ALL_EVENTS ((1UL << NOTIFY_EVENT_COUNT) - 1)
+
+struct NotifyMessage {
+  uint8_t event;           // NotifyEvent
+  char text[NOTIFY_MAX_MESSAGE];
+};
+
+// Short name used by the event-list settings, e.g. "reached"
+const char* notifyEventName(NotifyEvent event);
+
+// Parses "on,off,reached" (names as above), "all" or "none" into a mask.
+// An empty list means all.  Returns false on an unknown name.
+bool parseNotifyEvents(const char* text, uint32_t& mask);
+
+// Safety events are never held back
+bool notifyUrgent(NotifyEvent event);
+
+class NotifyCoalescer {
+public:
+  NotifyCoalescer();
+
+  // Offers a message.  True = send it now; false = it was folded into a
+  // pending message that due() will hand out when the window closes.
+  bool post(const NotifyMessage& msg, unsigned long nowMs, unsigned long windowMs);
+
+  // Hands out one merged message whose window has closed
+  bool due(unsigned long nowMs, NotifyMessage& out);
+
+  // Milliseconds until the next window closes, or NOTIFY_NEVER
+  unsigned long msUntilDue(unsigned long nowMs) const;
+
+private:
+  struct Slot {
+    bool open;                   // A window is running
+    bool pending;                // Something arrived during it
+    unsigned long windowEndMs;
+    unsigned long windowMs;
+    int merged;
+    NotifyMessage latest;
+  };
+
+  static int keyFor(NotifyEvent event);
+
+  Slot slots[NOTIFY_EVENT_COUNT];
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+// Firmware updates over the network, either with ArduinoOTA (espota, the
+// IDE or `pio run -t upload --upload-port sauna.local`) or by POSTing the
+// .bin to /update as a multipart form.  Both stream the image straight
+// into the inactive app partition, one chunk at a time.  The heater is
+// held off from the first chunk until the reboot, or until a failed
+// update gives up.  Needs OTA_PASSWORD (and optionally OTA_USER and
+// OTA_HOSTNAME) in secrets.h, otherwise updates stay off.
+//
+// A freshly flashed image boots on probation: otaSelfTest() keeps it, or
+// has the bootloader roll back to the previous one.
+
+// --- Task setup ---
+#define OTA_TASK_STACK 4096
+#define OTA_TASK_PRIORITY 1
+#define OTA_TASK_CORE 0
+
+#define OTA_POLL_MS 50
+#define OTA_REBOOT_DELAY_MS 1000      // Lets the /update reply get out first
+#define OTA_SELF_TEST_WAIT_MS 1000    // How long to give the supervisor to tick
+
+struct OtaStats {
+  bool enabled;
+  bool inProgress;
+  const char* partition;      // Running app partition, e.g. "app0"
+  const char* lastError;      // "" if the last update (if any) worked
+};
+
+// Starts the task serving ArduinoOTA once WiFi is up.  onStart runs on
+// whichever task receives the first chunk; keep it short (e.g. post a
+// command).  Call once from setup().
+void otaBegin(void (*onStart)());
+
+// /update: the body handler answers once the upload is complete, the
+// upload handler takes the image chunk by chunk.  Both check the login.
+void otaHandleUpdateDone(AsyncWebServerRequest* request);
+void otaHandleUpload(AsyncWebServerRequest* request, const String& filename, size_t index,
+                     uint8_t* data, size_t len, bool final);
+
+// Call in setup() once the probes and the supervisor are started.  On an
+// image that's on probation, marks it good if the checks pass and rolls
+// back (rebooting) if not.  Returns false only in the rollback case.
+bool otaSelfTest(bool sensorPresent);
+
+OtaStats otaGetStats();
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Lightweight timing probes for the hot paths.  Each probe keeps a count,
+// sum, min, max and a log2 histogram of durations in microseconds, from
+// which /metrics reports the average and an approximate p99.  Recording is
+// a few dozen cycles under a spinlock, so probes are safe from any task.
+
+#define PERF_MAX_PROBES 32
+#define PERF_BUCKETS 25               // Bucket i counts durations < 2^i us; the last one is open
+
+// One probe's figures, copied out under the lock
+struct PerfStats {
+  const char* name;
+  uint32_t count;
+  uint64_t sumUs;
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint32_t buckets[PERF_BUCKETS];
+};
+
+// Adds a probe and returns its id, or -1 once PERF_MAX_PROBES are in use
+// (recording to -1 is a no-op).  name must outlive the probe.
+int perfRegister(const char* name);
+
+// Adds one duration to a probe
+void perfRecordUs(int probe, uint32_t us);
+
+// Adds one duration measured with the cycle counter on `core` at `mhz`.
+// Dropped if the task has since moved to the other core, whose counter is
+// unrelated, or the CPU clock changed part way (the idle power mode), so
+// the cycles can't be converted.
+void perfRecordCycles(int probe, int core, uint32_t mhz, uint32_t cycles);
+
+int perfProbeCount();
+bool perfRead(int probe, PerfStats& out);
+
+// Upper bound of the bucket holding the p-th fraction of samples, clamped
+// to the largest duration seen
+uint32_t perfPercentileUs(const PerfStats& stats, float p);
+
+// Times the enclosing scope with the CPU cycle counter.  Wraps after 2^32
+// cycles (~17 s at 240 MHz), so keep it to paths well short of that.
+class PerfTimer {
+public:
+  explicit PerfTimer(int probe)
+      : probe(probe), core(xPortGetCoreID()), mhz(getCpuFrequencyMhz()), start(ESP.getCycleCount()) {}
+  ~PerfTimer() { perfRecordCycles(probe, core, mhz, ESP.getCycleCount() - start); }
+
+private:
+  int probe;
+  int core;
+  uint32_t mhz;
+  uint32_t start;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Arduino.h>
+#include <DallasTemperature.h>
+
+// Every DS18B20 on the OneWire bus.  The bus is searched once at boot and
+// the ROM addresses cached; after that a cycle is one broadcast "convert"
+// to all probes at once, then a direct read of each by address.
+
+#define MAX_PROBES 4
+#define PROBE_NAME_LEN 12
+
+// What each probe is for is set by ROM address (the probe role settings),
+// so replacing or adding a probe can never move the thermostat onto a
+// different one.  The bench probe drives the thermostat; with no probe in
+// that role the sauna won't heat.  Until a bench address is set the first
+// probe without a role stands in.  Probes are listed sorted by ROM address.
+enum ProbeRole : int8_t {
+  PROBE_UNASSIGNED = -1,
+  PROBE_BENCH,
+  PROBE_CEILING,
+  PROBE_HEATER,
+  PROBE_AUX,
+  PROBE_ROLE_COUNT
+};
+
+#define PROBE_NAMES { "bench", "ceiling", "heater", "aux" }
+#define PROBE_UNASSIGNED_NAME "unassigned"
+
+struct Probe {
+  DeviceAddress address;
+  char name[PROBE_NAME_LEN];   // The role's name, or PROBE_UNASSIGNED_NAME
+  ProbeRole role;
+  float tempF;      // DEVICE_DISCONNECTED_F until the first good read
+};
+
+// Scans the bus and sets every probe's resolution.  Returns the count found.
+// Every probe starts unassigned; follow with probesAssignRoles().
+int probesBegin(uint8_t pin, uint8_t resolution);
+
+// Gives each probe the role whose address (16 hex digits, as written by
+// formatProbeAddress) matches its own; empty entries are unassigned.  An
+// empty bench entry falls back to the first probe left without a role.
+void probesAssignRoles(const char* const addresses[PROBE_ROLE_COUNT]);
+
+// True if a probe on the bus holds the bench role
+bool probesHaveControl();
+
+int probeCount();
+const Probe& probe(int index);
+
+// Changes every probe's resolution (RAM only, no EEPROM wear)
+void probesSetResolution(uint8_t resolution);
+uint8_t probesResolution();
+
+// How long a conversion takes at the current resolution
+unsigned long probesConversionMs();
+
+// Starts a conversion on all probes at once (never blocks)
+void probesRequest();
+
+// True once every probe on the bus has finished converting
+bool probesReady();
+
+// Reads each cached probe by address.  Bad reads (CRC error, unplugged)
+// are stored as DEVICE_DISCONNECTED_F.
+void probesRead();
+
+// The bench probe's temperature, or DEVICE_DISCONNECTED_F (also when no
+// probe holds the role)
+float controlTempF();
+
+// Formats a ROM address as 16 hex digits into buf (at least 17 bytes)
+void formatProbeAddress(const DeviceAddress address, char* buf);
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Last line of defence for the heater.  A high-priority supervisor task,
+// itself on the ESP32 task watchdog, owns the SSR pin and forces it low
+// when a hard limit is hit, whatever state the control loop is in.  It
+// never touches the sensor bus or the network: loop() reports readings
+// and heartbeats here, and silence is itself a reason to cut the heater.
+//
+// A trip latches until the session is off and the cause has cleared.
+
+// --- Supervisor task ---
+#define SAFETY_TASK_STACK 2048
+#define SAFETY_TASK_PRIORITY (configMAX_PRIORITIES - 2)  // Above everything but the IDF's own
+#define SAFETY_TASK_CORE 1                               // With loop(), which it preempts
+#define SAFETY_PERIOD_MS 100          // Worst-case latency from a limit to SSR low
+#define SAFETY_WDT_TIMEOUT_S 5        // Supervisor itself stalled = reboot (SSR resets low)
+
+// --- Hard limits, independent of the thermostat and the max time setting ---
+#define SAFETY_MAX_TEMP_F 240.0f          // Control (bench) probe
+#define SAFETY_MAX_PROBE_F 275.0f         // Any probe, the heater one included
+#define SAFETY_SENSOR_TIMEOUT_MS 10000    // No valid control reading for this long, in a session
+#define SAFETY_LOOP_STALL_MS 5000         // loop() heartbeat missing for this long
+#define SAFETY_MAX_SESSION_MS (150 * 60000UL)  // Session on, however it was extended
+
+enum SafetyTrip {
+  SAFETY_OK = 0,
+  SAFETY_OVER_TEMP,
+  SAFETY_SENSOR_TIMEOUT,
+  SAFETY_MAX_ON_TIME,
+  SAFETY_LOOP_STALLED
+};
+
+// Drives pin low, then starts the supervisor and subscribes it to the task
+// watchdog.  onTrip runs on the supervisor task when a trip latches (keep
+// it short, e.g. wakeLoop()).
+void safetyBegin(uint8_t pin, void (*onTrip)());
+
+// Switches the SSR.  Refused (pin stays low) while tripped; returns the
+// state the pin was actually left in.
+bool safetySetHeater(bool on);
+
+// Session on/off, for the on-time limit and clearing trips.  Starting one
+// also restarts the sensor-timeout count, which only runs in a session.
+void safetySetSession(bool active);
+
+// Latest control-probe reading (DEVICE_DISCONNECTED_F if it failed) and the
+// hottest probe, from the normal sampling path
+void safetyReportTemps(float controlF, float hottestF);
+
+// Called every loop() pass
+void safetyLoopAlive();
+
+// Holds the SSR low without tripping, e.g. for a firmware update.  Heater
+// requests are refused until it is released.
+void safetyInhibit(bool inhibit);
+
+// Total time the SSR has been driven on since boot, in µs, counting the
+// current on-period.  Stamped at each pin change, whoever made it.
+uint64_t safetyHeaterOnUs();
+
+// True while the supervisor task is ticking
+bool safetyRunning();
+
+SafetyTrip safetyTripped();
+unsigned long safetyTripCount();
+const char* safetyTripName(SafetyTrip trip);
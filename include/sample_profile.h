@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+// Picks the DS18B20 resolution and sampling period for the current phase
+// of a session.  Climbing from cold, coarse readings every couple of
+// seconds are plenty; near the setpoint the thermostat wants fine, fast
+// samples.  Pure logic so it can be exercised off-device.
+
+struct SampleProfile {
+  uint8_t resolution;         // DS18B20 bits, 9..12
+  unsigned long periodMs;     // Time between conversion starts
+};
+
+#define SAMPLE_NEAR_BAND_F 15.0f   // Within this of setpoint = fine sampling
+#define SAMPLE_LEAVE_BAND_F 20.0f  // Back to coarse only beyond this
+
+static const SampleProfile SAMPLE_IDLE = { 10, 2000 };    // Sauna off
+static const SampleProfile SAMPLE_HEATING = { 9, 2000 };  // Climbing from cold
+static const SampleProfile SAMPLE_HOLDING = { 12, 1000 }; // Close to setpoint
+
+// Returns the profile to use next.  current is the one in use now, so the
+// near/far switch has hysteresis and doesn't flap around the band edge.
+SampleProfile chooseSampleProfile(const SampleProfile& current, bool sessionActive,
+                                  float tempF, float setpointF);
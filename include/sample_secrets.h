@@ -2,4 +2,23 @@
 #define WIFI_PWD_1 "<PWD1>"
 #define WIFI_SSID_2 "<SSID2>"
 #define WIFI_PWD_2 "<PWD2>"
-#define DISCORD_WEBHOOK_URL "https://discord.com/api/webhooks/XXXXXXXXXXXX/XXXXXXXXX"
\ No newline at end of file
+#define DISCORD_WEBHOOK_URL "https://discord.com/api/webhooks/XXXXXXXXXXXX/XXXXXXXXX"
+// Optional: POSIX time zone for scheduled starts (defaults to UTC)
+// #define TIME_ZONE "EST5EDT,M3.2.0,M11.1.0"
+
+// Optional: MQTT broker for Home Assistant (leave MQTT_HOST undefined to disable)
+// #define MQTT_HOST "192.168.1.10"
+// #define MQTT_PORT 1883
+// #define MQTT_USER "sauna"
+// #define MQTT_PWD "<MQTTPWD>"
+
+// Optional: network firmware updates via ArduinoOTA and POST /update
+// (leave OTA_PASSWORD undefined to disable)
+// #define OTA_PASSWORD "<OTAPWD>"
+// #define OTA_USER "admin"
+// #define OTA_HOSTNAME "sauna"
+
+// Optional: ntfy push notifications, alongside Discord (leave NTFY_URL
+// undefined to disable).  Which events each sink gets is set on /config.
+// #define NTFY_URL "https://ntfy.sh/<TOPIC>"
+// #define NTFY_TOKEN "<NTFYTOKEN>"
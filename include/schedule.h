@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+// Future sauna starts: one-off ("Friday 19:30", or "in 40 minutes") and
+// weekly ("Saturdays at 17:00").  Times are wall-clock, resolved with the
+// C library's local time (TZ), so weekly entries follow DST.  Pure logic;
+// the caller supplies the clock and decides how early to start.
+
+#define SCHEDULE_MAX_ENTRIES 8
+#define SCHEDULE_MISSED_GRACE_S 600   // Still start up to 10 min late (e.g. after a reboot)
+
+struct ScheduleEntry {
+  bool used;
+  uint8_t weekdays;        // Bit 0 = Sunday .. bit 6 = Saturday; 0 = one-off
+  uint16_t minuteOfDay;    // Weekly: local start time
+  uint32_t onceEpoch;      // One-off: start time
+  uint8_t durationMin;     // Session length once at temperature
+  bool preheat;            // Start early so the room is hot at the start time
+  int16_t setpointF;       // 0 = keep the current setpoint
+  uint32_t lastFiredEpoch; // Occurrence most recently started (weekly)
+};
+
+class Scheduler {
+public:
+  Scheduler();
+
+  // Stores entry in a free slot.  Returns its id, or -1 if full/invalid.
+  int add(const ScheduleEntry& entry);
+  bool remove(int id);
+  void clear();
+
+  const ScheduleEntry& entry(int id) const { return entries[id]; }
+
+  // When entry id next wants the room ready, or 0 if never
+  time_t nextStart(int id, time_t now) const;
+
+  // Finds an entry that should start now, copying it to fired and its
+  // start time to start.  leadS(id) says how many seconds before its start
+  // an entry should fire.  The entry is marked fired (one-offs are
+  // removed) before returning.  False if nothing is due.
+  template <typename Lead>
+  bool due(time_t now, Lead leadS, ScheduleEntry& fired, time_t& start);
+
+  // Soonest upcoming start across all entries (0 = none) and its id
+  time_t soonest(time_t now, int* idOut = nullptr) const;
+
+  // Raw slots, for persisting
+  ScheduleEntry* data() { return entries; }
+  static const int SIZE = SCHEDULE_MAX_ENTRIES;
+
+private:
+  ScheduleEntry entries[SCHEDULE_MAX_ENTRIES];
+  void markFired(int id, time_t start);
+};
+
+template <typename Lead>
+bool Scheduler::due(time_t now, Lead leadS, ScheduleEntry& fired, time_t& start) {
+  for (int id = 0; id < SCHEDULE_MAX_ENTRIES; id++) {
+    if (!entries[id].used) continue;
+    start = nextStart(id, now);
+    if (start == 0 || now < start - leadS(id)) continue;
+
+    fired = entries[id];
+    markFired(id, start);
+    return true;
+  }
+  return false;
+}
+
+// Parses "sat", "sat,sun", "weekdays", "weekends" or "daily" into a mask.
+// Returns 0 on anything it doesn't recognise.
+uint8_t parseWeekdays(const char* text);
+
+// Formats mask as e.g. "Sat,Sun" (or "Daily") into buf
+void formatWeekdays(uint8_t mask, char* buf, size_t len);
@@ -0,0 +1,11 @@
+#pragma once
+
+#include "schedule.h"
+
+// Scheduled starts persisted in NVS, so a reboot or power cut keeps them
+
+// Loads the saved entries into scheduler.  Returns false (scheduler
+// untouched) if none are saved or they are from an older layout.
+bool loadSchedule(Scheduler& scheduler);
+
+void saveSchedule(Scheduler& scheduler);
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Append-only log of finished sauna sessions on LittleFS.  Records are a
+// fixed 40 bytes with their own CRC, so paging is a seek and a torn write
+// only ever costs the last record.  A background task owns the files: it
+// alone touches LittleFS, batching appends to keep flash writes (which
+// stall both cores) rare, and answering reads.  Callers only ever hand it
+// messages through a queue, so no lock is held across flash I/O and an
+// append never waits.
+
+#define SESSION_LOG_FILE "/sessions.log"
+#define SESSION_LOG_OLD_FILE "/sessions.old"
+#define SESSION_LOG_MAX_BYTES (32 * 1024)   // Rotate to .old beyond this (~800 sessions)
+#define SESSION_PENDING_MAX 8               // Records held in RAM before a forced flush
+#define SESSION_FLUSH_MS 60000              // Longest a record waits in RAM
+#define SESSION_QUEUE_LENGTH 8              // Messages waiting for the log task
+#define SESSION_READ_TIMEOUT_MS 500         // Longest a reader waits for its answer
+#define SESSION_PAGE_MAX 50                 // Most records one page read returns
+
+#define SESSION_RECORD_MAGIC 0x5353         // "SS"
+#define SESSION_RECORD_VERSION 2            // 2: energyWh, holdDutyPermille
+#define SESSION_NEVER_REACHED 0xFFFFFFFFUL
+#define SESSION_NEVER_HELD 0xFFFF           // holdDutyPermille if it never got there
+#define SESSION_NO_PEAK INT16_MIN           // peakCentiF if no reading was ever taken
+
+enum SessionEndReason : uint8_t {
+  SESSION_END_UNKNOWN = 0,
+  SESSION_END_TIMER,       // Countdown ran out
+  SESSION_END_MENU,        // "Stop" on the encoder
+  SESSION_END_WEB,         // /off
+  SESSION_END_FAULT,       // Shut down by a safety check
+  SESSION_END_MQTT,        // Power OFF over MQTT
+  SESSION_END_OTA          // A firmware update started
+};
+
+struct __attribute__((packed)) SessionRecord {
+  uint16_t magic;
+  uint8_t version;
+  uint8_t endReason;         // SessionEndReason
+  uint32_t startEpoch;       // Wall clock at start, 0 if not known
+  uint32_t startUptimeS;
+  uint32_t durationS;
+  uint32_t timeToTargetS;    // SESSION_NEVER_REACHED if it never got there
+  int16_t peakCentiF;
+  int16_t setpointCentiF;
+  uint16_t dutyPermille;     // Heater on-time / session time
+  uint32_t heaterOnS;
+  uint16_t energyWh;         // Heater energy at the configured wattage (v2)
+  uint16_t holdDutyPermille; // Duty from first reaching the setpoint to the end (v2)
+  uint8_t reserved[4];       // Zero; room for later fields
+  uint16_t crc;              // CRC-16/CCITT of everything above
+};
+
+// Mounts LittleFS (formatting it if needed) and starts the flush task
+void sessionLogBegin();
+
+// Stamps the magic/version/CRC and queues the record.  Never blocks; the
+// record is dropped (and logged) if the queue is full.
+void sessionLogAppend(SessionRecord record);
+
+// Reads up to max (at most SESSION_PAGE_MAX) records into out, newest
+// first, passing over the skip newest; torn or corrupt ones are left out.
+// total is set to the records stored, flushed or not.  One round trip to
+// the log task, waiting up to SESSION_READ_TIMEOUT_MS; returns the count
+// read, or -1 if it didn't answer in time.
+int sessionLogReadPage(uint32_t skip, uint32_t max, SessionRecord* out, uint32_t& total);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdint.h>
+
+// Decides which session changes are worth telling someone about: the
+// sauna turning on or off, the room first reaching the setpoint, and the
+// countdown passing the "minutes left" warning.  "Reached" fires once, and
+// re-arms when a session starts or the setpoint moves; the warning re-arms
+// when a session starts or added time lifts the countdown back above it.
+// Pure logic; the caller sends the messages.
+
+#define SESSION_EVENT_ON        (1UL << 0)
+#define SESSION_EVENT_OFF       (1UL << 1)
+#define SESSION_EVENT_REACHED   (1UL << 2)
+#define SESSION_EVENT_MINUTES_LEFT (1UL << 3)
+
+class SessionMonitor {
+public:
+  SessionMonitor() : lastOn(false), reachedSent(false), warningSent(false) {}
+
+  // Call once per pass with the current state; returns the events seen.
+  // warnMs = 0 turns the minutes-left warning off.
+  uint32_t update(bool saunaOn, float tempF, float setpointF,
+                  unsigned long remainingMs, unsigned long warnMs);
+
+  // The setpoint changed, so the next crossing is news again
+  void rearm() { reachedSent = false; }
+
+private:
+  bool lastOn;
+  bool reachedSent;
+  bool warningSent;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <Arduino.h>
+
+// User-tunable settings, described once in a registry table that drives
+// NVS storage, the /config page and the encoder "Settings" menu.  They
+// are loaded into the RAM struct below at boot, so the hot paths just read
+// a field; only edits touch flash.  Only loop() changes them: other tasks
+// validate with settingValid() and hand the edit over with postSetting()
+// (controller.h).
+
+#define SETPOINT_MIN_F 80.0f
+#define SETPOINT_MAX_F 230.0f
+
+#define SETTING_SSID_LEN 33        // 32 + null, per 802.11
+#define SETTING_PWD_LEN 65         // WPA2 passphrase / PSK
+#define SETTING_EVENTS_LEN 64      // Notification event list, see notify_rules.h
+#define SETTING_ADDR_LEN 17        // Probe ROM address, 16 hex digits + null
+
+struct Settings {
+  int32_t maxTimeMin;              // Longest countdown anything may set
+  int32_t onTimeMin;               // Session length for "on" (web, MQTT)
+  int32_t addTimeMin;              // "Add time" increment
+  float setpointF;                 // Setpoint at boot
+  int32_t maxResolution;           // Finest DS18B20 resolution used, 9..12 bits
+  char wifiSsid1[SETTING_SSID_LEN];  // Empty = the one from secrets.h
+  char wifiPwd1[SETTING_PWD_LEN];
+  char wifiSsid2[SETTING_SSID_LEN];
+  char wifiPwd2[SETTING_PWD_LEN];
+  int32_t notifyLeftMin;           // "Minutes left" warning, 0 = off
+  int32_t notifyWindowS;           // Coalescing window for repeats, 0 = off
+  char discordEvents[SETTING_EVENTS_LEN];  // Empty = all events
+  char mqttEvents[SETTING_EVENTS_LEN];
+  char ntfyEvents[SETTING_EVENTS_LEN];
+  int32_t heaterWatts;             // Rated heater power, for the energy figures
+  int32_t idleMin;                 // Idle power mode after this long untouched, 0 = never
+  char probeBench[SETTING_ADDR_LEN];    // Probe roles by ROM address, empty = none;
+  char probeCeiling[SETTING_ADDR_LEN];  // in ProbeRole order (see probes.h)
+  char probeHeater[SETTING_ADDR_LEN];
+  char probeAux[SETTING_ADDR_LEN];
+};
+
+extern Settings settings;
+
+enum SettingType {
+  SETTING_INT,
+  SETTING_FLOAT,
+  SETTING_TEXT
+};
+
+#define SETTING_SECRET (1 << 0)    // Never sent back out, only "set" or not
+#define SETTING_MENU   (1 << 1)    // Editable from the encoder
+
+struct SettingDef {
+  const char* key;        // NVS key and form field (<= 15 chars)
+  const char* label;      // Fits the LCD (<= 16 chars)
+  SettingType type;
+  size_t offset;          // Into Settings
+  size_t size;            // Text: buffer size including the null
+  float min;              // Numbers: range and encoder step
+  float max;
+  float step;
+  float defaultNumber;
+  const char* unit;
+  uint8_t flags;
+  bool (*validate)(const char* text);   // Text: optional extra check
+};
+
+// Loads defaults, then anything saved in NVS.  Call once, early in setup().
+void settingsBegin();
+
+int settingCount();
+const SettingDef& settingDef(int index);
+int settingFind(const char* key);       // -1 if unknown
+
+// Numeric value of a number setting
+float settingNumber(int index);
+
+// True if text parses and is in range for the setting.  Safe from any task.
+bool settingValid(int index, const char* text);
+
+// Validates text, updates RAM and saves to NVS (loop() only).  False
+// (nothing changed) if it doesn't parse or is out of range.
+bool settingSet(int index, const char* text);
+
+// Writes the current value as text; secrets come out empty.  Safe from any
+// task: text is copied under the same lock settingSet() updates it under.
+void settingFormat(int index, char* buf, size_t len);
+
+// Copies a text setting's field (settings.wifiPwd1, say), secrets included.
+// For tasks other than loop(): copied under the lock settingSet() writes
+// it under, so a string mid-edit is never seen half old, half new.
+void settingCopyText(const char* field, char* buf, size_t len);
+
+// True if a text setting is non-empty (lets /config say a secret is set)
+bool settingIsSet(int index);
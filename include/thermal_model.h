@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+
+// Online first-order model of the sauna room, used to predict when it will
+// reach the setpoint.  Every THERMAL_STEP_S the mean temperature T and mean
+// heater duty u over that step are fed in, and recursive least squares fits
+//
+//   T[k+1] - T[k] = a * u[k] + b * T[k] + c
+//
+// which is Newton cooling towards ambient (b < 0, c = -b * ambient) plus a
+// heating term a.  The fit keeps running whether the sauna is on or off,
+// so it remembers the room between sessions.  Pure logic, no hardware.
+
+#define THERMAL_STEP_S 30             // Seconds between model updates
+#define THERMAL_FORGETTING 0.998      // Per step; ~4 h memory
+#define THERMAL_P_INIT 1000.0         // Initial covariance (no prior knowledge)
+#define THERMAL_P_TRACE_MAX 1.0e5     // Stop forgetting above this (no excitation)
+#define THERMAL_MIN_UPDATES 20        // Updates before an ETA is offered (10 min)
+#define THERMAL_TEMP_SCALE 100.0      // T is fitted as T / scale for conditioning
+
+class ThermalModel {
+public:
+  ThermalModel();
+
+  // Forgets everything learned
+  void reset();
+
+  // One step's mean temperature and heater duty (0..1)
+  void update(float meanTempF, float meanDuty);
+
+  // True once the fit has seen enough data and describes a room that
+  // heats when powered and cools towards ambient
+  bool converged() const;
+
+  // Seconds from tempF until setpointF at the given duty, or -1 if not
+  // converged or the model says that duty cannot get there
+  long etaSeconds(float tempF, float setpointF, float duty = 1.0f) const;
+
+  // Where the room settles at a constant duty (meaningless unless converged)
+  float steadyStateF(float duty) const;
+
+  // Cooling time constant in seconds (meaningless unless converged)
+  float timeConstantS() const;
+
+  uint32_t updates() const { return updateCount; }
+
+private:
+  double theta[3];     // a, b (per scaled degree), c (scaled)
+  double P[3][3];
+  bool havePrevious;
+  double previousT;    // Scaled
+  double previousU;
+  uint32_t updateCount;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+// Closed-loop temperature control for the heater SSR.  The PID output is a
+// 0..1 duty that's turned into slow PWM over a fixed time window, which suits
+// a zero-crossing SSR and a thermal mass that reacts over minutes.  Nothing
+// here touches hardware, so it runs the same off-device.
+
+// --- Tuning ---
+#define THERMOSTAT_WINDOW_MS 10000     // Time-proportioning period
+#define THERMOSTAT_MIN_PULSE_MS 250    // Shorter on/off slivers are rounded away
+#define THERMOSTAT_PID_BAND_F 15.0f    // Further below setpoint than this = full on
+#define THERMOSTAT_HYSTERESIS_F 2.0f   // On/off fallback switches on this far below
+#define THERMOSTAT_D_FILTER 0.2f       // Derivative low-pass (0..1, lower = smoother)
+
+// Default gains, per °F of error and per second.  Deliberately soft; a
+// tuned set replaces them.
+#define THERMOSTAT_DEFAULT_KP 0.10f
+#define THERMOSTAT_DEFAULT_KI 0.0002f
+#define THERMOSTAT_DEFAULT_KD 6.0f
+
+struct PidGains {
+  float kp;
+  float ki;
+  float kd;
+};
+
+enum ThermostatMode {
+  THERMOSTAT_PID,
+  THERMOSTAT_HYSTERESIS    // Plain on/off, used when no usable gains are set
+};
+
+class Thermostat {
+public:
+  Thermostat();
+
+  void setSetpoint(float setpointF) { setpoint = setpointF; }
+  float getSetpoint() const { return setpoint; }
+
+  // All-zero gains select the hysteresis fallback
+  void setGains(const PidGains& newGains);
+  PidGains getGains() const { return gains; }
+  ThermostatMode getMode() const { return mode; }
+
+  // Clears integral/derivative history and restarts the PWM window.
+  // Call when a session starts.
+  void reset(unsigned long nowMs);
+
+  // Feeds a new temperature sample and recomputes the duty
+  void update(float tempF, unsigned long nowMs);
+
+  // Drops the duty to zero until the next valid sample (sensor fault)
+  void fault();
+
+  // Forces the duty (e.g. the autotune relay) until the next update()
+  void setOutput(float newDuty);
+
+  // Whether the SSR should conduct right now
+  bool heaterOn(unsigned long nowMs);
+
+  // Milliseconds until heaterOn() next changes on its own
+  unsigned long nextSwitchMs(unsigned long nowMs);
+
+  // Current duty, 0..1
+  float output() const { return duty; }
+
+private:
+  void advanceWindow(unsigned long nowMs);
+  unsigned long onTimeMs() const;
+
+  PidGains gains;
+  ThermostatMode mode;
+  float setpoint;
+
+  float duty;
+  float integral;
+  float dFiltered;
+  float lastTempF;
+  unsigned long lastUpdateMs;
+  bool havePrevious;
+
+  bool hysteresisOn;
+  unsigned long windowStartMs;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <Arduino.h>
+
+// The control loop sleeps on its task notification until something worth
+// reacting to happens.  Each producer sets its own bit, so one wake can
+// carry several reasons and none of them are lost.
+
+#define WAKE_TEMP       (1UL << 0)   // Temperature timer fired
+#define WAKE_INPUT      (1UL << 1)   // Encoder or button event queued
+#define WAKE_COMMAND    (1UL << 2)   // A web handler changed the state
+#define WAKE_COUNTDOWN  (1UL << 3)   // Countdown crossed a second or expired
+#define WAKE_HEATER     (1UL << 4)   // Time-proportioning window edge
+#define WAKE_HISTORY    (1UL << 5)   // 1 s history sample due
+#define WAKE_SAFETY     (1UL << 6)   // Safety supervisor cut the heater
+
+// Records the calling task as the one to wake.  Call from setup().
+void wakeBegin();
+
+// Wakes the control loop.  Safe from any task; a no-op before wakeBegin().
+void wakeLoop(uint32_t reasons);
+
+// Blocks the control loop until woken or timeout; returns the reasons.
+uint32_t waitForWake(TickType_t timeout);
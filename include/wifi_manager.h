@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Keeps the station connected from a background task, so boot never waits
+// on the network and a dropped link comes back on its own.  The last good
+// access point (BSSID and channel) is cached in NVS: a reboot joins it
+// directly without a scan, and only falls back to scanning both of
+// WIFI_SSID_1 and WIFI_SSID_2 (or their /config overrides) when that fails.
+
+// --- Task setup ---
+#define WIFI_TASK_STACK 4096
+#define WIFI_TASK_PRIORITY 1
+#define WIFI_TASK_CORE 0
+
+// --- Timing ---
+#define WIFI_POLL_MS 250
+#define WIFI_FAST_TIMEOUT_MS 5000     // Cached BSSID/channel, no scan
+#define WIFI_SCAN_TIMEOUT_MS 15000    // Full scan for one SSID
+#define WIFI_RETRY_MS 5000            // Pause after both SSIDs failed, doubled each round
+#define WIFI_RETRY_MAX_MS 60000
+
+enum WifiState {
+  WIFI_STARTING,
+  WIFI_FAST_CONNECT,   // Trying the cached access point
+  WIFI_CONNECTING,     // Scanning for one of the SSIDs
+  WIFI_CONNECTED,
+  WIFI_WAITING         // Both failed; backing off before the next round
+};
+
+struct WifiStats {
+  WifiState state;
+  unsigned long connects;
+  unsigned long fastConnects;    // Of those, joined from the cache
+  unsigned long drops;           // Lost an established link
+  unsigned long lastConnectMs;   // How long the last successful join took
+};
+
+// Sets station mode and starts the manager task.  onConnected runs on the
+// manager task after every successful join (may be NULL).
+void wifiManagerBegin(void (*onConnected)());
+
+WifiStats wifiGetStats();
+const char* wifiStateName(WifiState state);
@@ -0,0 +1,66 @@
+# PlatformIO pre-build script: gzips each page in web/ into a PROGMEM byte
+# array (web/index.html -> include/index_html_gz.h, INDEX_HTML_*) so the
+# firmware can stream it straight from flash with Content-Encoding: gzip.
+# The ETag is a hash of the page, so browsers get a 304 until the page
+# itself changes.
+
+import gzip
+import hashlib
+import os
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO
+    PROJECT_DIR = env["PROJECT_DIR"]  # noqa: F821
+except NameError:
+    PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+PAGES = ["index.html", "config.html"]
+
+
+def render(html, name, prefix):
+    # mtime=0 keeps the output (and so the ETag) identical between builds
+    blob = gzip.compress(html, compresslevel=9, mtime=0)
+    etag = hashlib.sha1(html).hexdigest()[:16]
+
+    lines = [
+        "// Generated by scripts/embed_web.py from web/%s - do not edit" % name,
+        "#pragma once",
+        "",
+        "#include <Arduino.h>",
+        "",
+        '#define %s_ETAG "\\"%s\\""' % (prefix, etag),
+        "#define %s_GZ_LEN %d" % (prefix, len(blob)),
+        "",
+        "const uint8_t %s_GZ[] PROGMEM = {" % prefix,
+    ]
+    for i in range(0, len(blob), 16):
+        chunk = blob[i:i + 16]
+        lines.append("  " + ", ".join("0x%02x" % b for b in chunk) + ",")
+    lines.append("};")
+    return "\n".join(lines) + "\n"
+
+
+def embed(name):
+    stem = os.path.splitext(name)[0]
+    source = os.path.join(PROJECT_DIR, "web", name)
+    target = os.path.join(PROJECT_DIR, "include", "%s_html_gz.h" % stem)
+    with open(source, "rb") as f:
+        header = render(f.read(), name, "%s_HTML" % stem.upper())
+
+    # Only touch the header when the page changed, to avoid needless rebuilds
+    if os.path.exists(target):
+        with open(target) as f:
+            if f.read() == header:
+                return
+
+    with open(target, "w") as f:
+        f.write(header)
+    print("embed_web: regenerated %s" % os.path.relpath(target, PROJECT_DIR))
+
+
+def main():
+    for name in PAGES:
+        embed(name)
+
+
+main()
@@ -0,0 +1,46 @@
+#include <math.h>
+#include "plant.h"
+
+PlantParams defaultPlant() {
+  PlantParams p;
+  p.ambientF = 70.0f;
+  p.heaterW = 6000.0f;
+  p.stonesJPerF = 20000.0f;
+  p.airJPerF = 86400.0f;
+  p.stonesToAirWPerF = 150.0f;
+  p.lossWPerF = 24.0f;
+  p.probeTauS = 30.0f;
+  p.noiseF = 0.1f;
+  return p;
+}
+
+SaunaPlant::SaunaPlant(const PlantParams& params, uint32_t seed)
+    : p(params), stones(params.ambientF), air(params.ambientF), probe(params.ambientF),
+      rng(seed ? seed : 1) {}
+
+void SaunaPlant::step(bool heaterOn, float dtS) {
+  float toAir = p.stonesToAirWPerF * (stones - air);
+  float loss = p.lossWPerF * (air - p.ambientF);
+  stones += ((heaterOn ? p.heaterW : 0.0f) - toAir) * dtS / p.stonesJPerF;
+  air += (toAir - loss) * dtS / p.airJPerF;
+  probe += (air - probe) * dtS / p.probeTauS;
+}
+
+float SaunaPlant::readF(uint8_t resolution) {
+  // DS18B20 steps are 0.0625 C at 12 bits, doubling per bit dropped
+  float stepF = 0.1125f * (1 << (12 - resolution));
+  float reading = probe + gaussian() * p.noiseF;
+  return roundf(reading / stepF) * stepF;
+}
+
+// Box-Muller over xorshift32, so runs are repeatable for a given seed
+float SaunaPlant::gaussian() {
+  float u[2];
+  for (int i = 0; i < 2; i++) {
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    u[i] = (rng >> 8) * (1.0f / 16777216.0f) + 1e-7f;
+  }
+  return sqrtf(-2.0f * logf(u[0])) * cosf(6.2831853f * u[1]);
+}
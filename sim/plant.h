@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdint.h>
+
+// Simulated sauna for the off-device harness.  Two thermal nodes: the
+// heater element and stones, which take the SSR power, and the room air,
+// which they warm and which loses heat to ambient.  The lag between them
+// is what makes a real sauna overshoot.  A DS18B20 model on top adds the
+// probe's own lag, noise and the quantisation of the chosen resolution.
+
+struct PlantParams {
+  float ambientF;          // Room starts here and leaks towards it
+  float heaterW;           // Element power with the SSR on
+  float stonesJPerF;       // Heat capacity of the element and stones
+  float airJPerF;          // Heat capacity of the air, benches and walls
+  float stonesToAirWPerF;  // Coupling, stones to air
+  float lossWPerF;         // Air to ambient through the walls
+  float probeTauS;         // DS18B20 in its housing, first-order lag
+  float noiseF;            // Reading noise, standard deviation
+};
+
+// 6 kW heater, ~1 h room time constant, settles near 320 F flat out
+PlantParams defaultPlant();
+
+class SaunaPlant {
+public:
+  explicit SaunaPlant(const PlantParams& params, uint32_t seed = 1);
+
+  // Advances the plant by dtS seconds with the SSR on or off
+  void step(bool heaterOn, float dtS);
+
+  // What the control probe reads now at the given DS18B20 resolution
+  float readF(uint8_t resolution);
+
+  float airF() const { return air; }
+
+private:
+  float gaussian();
+
+  PlantParams p;
+  float stones;
+  float air;
+  float probe;
+  uint32_t rng;
+};
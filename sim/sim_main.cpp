@@ -0,0 +1,494 @@
+// Off-device harness: drives the firmware's pure control modules (menu,
+// countdown, session notifications, thermostat, autotune, thermal model,
+// sample profiles) against the simulated sauna in plant.h, then times the
+// calls loop() makes.  Build and run with
+//
+//   pio run -e native -t exec
+//
+// Runs are seeded, so the same code gives the same report; compare the
+// control figures before and after a change to the control logic.  Each
+// scenario also carries limits, and the run exits non-zero when a result
+// lands outside them, so a control regression fails the build.
+
+#include <stdio.h>
+#include <math.h>
+#include <string.h>
+#include <chrono>
+#include "plant.h"
+#include "menu.h"
+#include "countdown.h"
+#include "session_monitor.h"
+#include "thermostat.h"
+#include "autotune.h"
+#include "thermal_model.h"
+#include "sample_profile.h"
+#include "history.h"
+#include "energy.h"
+
+#define SIM_STEP_MS 100
+#define SIM_REACHED_BAND_F 1.0f      // Within this of setpoint counts as there
+#define SIM_HOLD_WINDOW_S (30 * 60)  // Holding figures cover the session's last 30 min
+#define SIM_NOTIFY_QUEUE 8           // Matches NOTIFY_QUEUE_LENGTH
+#define SIM_NOTIFY_POST_MS 400       // One webhook POST on a healthy link
+#define SIM_WARN_MS (10 * 60000UL)   // The "Warn at" default
+
+// Same items as the LCD menu, so the scripted presses below match the device
+static const char* const MENU_ITEMS[] = {"Start", "Stop", "Set", "Tune", "Sched", "Temps", "IP", "Settings"};
+static const int MENU_LENGTH = 8;
+
+// --- Network ---
+// The webhook: messages wait in a drop-oldest queue like the notifier's,
+// and the link goes dead for stallMs out of every stallEveryMs.
+struct NotifySink {
+  unsigned long stallEveryMs;
+  unsigned long stallMs;
+  bool blocking;              // Pre-notifier behaviour: the caller waits for the POST
+
+  unsigned long queued[SIM_NOTIFY_QUEUE];
+  int count;
+  unsigned long busyUntilMs;
+  unsigned sent;
+  unsigned dropped;
+  unsigned long worstDelayMs;
+
+  bool linkUp(unsigned long nowMs) const {
+    return stallEveryMs == 0 || nowMs % stallEveryMs >= stallMs;
+  }
+
+  // Milliseconds from nowMs until a POST started then would complete
+  unsigned long postTime(unsigned long nowMs) const {
+    unsigned long wait = 0;
+    while (!linkUp(nowMs + wait)) wait += SIM_STEP_MS;
+    return wait + SIM_NOTIFY_POST_MS;
+  }
+
+  // Returns how long the caller is held up
+  unsigned long send(unsigned long nowMs) {
+    if (blocking) {
+      unsigned long took = postTime(nowMs);
+      sent++;
+      if (took > worstDelayMs) worstDelayMs = took;
+      return took;
+    }
+    if (count == SIM_NOTIFY_QUEUE) {
+      memmove(queued, queued + 1, sizeof(queued[0]) * (count - 1));
+      count--;
+      dropped++;
+    }
+    queued[count++] = nowMs;
+    return 0;
+  }
+
+  // The sender task's side, once per simulation step
+  void service(unsigned long nowMs) {
+    if (count == 0 || nowMs < busyUntilMs || !linkUp(nowMs)) return;
+    busyUntilMs = nowMs + SIM_NOTIFY_POST_MS;
+    unsigned long delay = busyUntilMs - queued[0];
+    if (delay > worstDelayMs) worstDelayMs = delay;
+    memmove(queued, queued + 1, sizeof(queued[0]) * (count - 1));
+    count--;
+    sent++;
+  }
+};
+
+// --- Scenarios ---
+// What a scenario must still manage; the margins leave room for tuning
+struct Limits {
+  long maxTimeToTargetS;
+  float maxOvershootF;
+  float maxHoldDuty;
+  float maxHoldRmsF;
+};
+
+struct Scenario {
+  const char* name;
+  PlantParams plant;
+  PidGains gains;              // All zero = hysteresis
+  bool autotuneFirst;          // Tune in a first session, score the second
+  float setpointF;
+  int sessionMin;
+  uint8_t maxResolution;       // The "maxRes" setting
+  unsigned long stallEveryMs;
+  unsigned long stallMs;
+  bool blockingNotify;
+  uint32_t seed;
+  Limits limits;
+};
+
+struct Result {
+  long timeToTargetS;          // -1 = never got there
+  float overshootF;
+  float holdDuty;
+  float holdRmsF;
+  float kwh;                   // Heater energy over the whole session
+  long etaAt10MinS;            // Model's prediction 10 min in, -1 = none yet
+  long sessionS;               // When the countdown ended the session
+  PidGains gains;              // What the scored session ran with
+  long tuneS;                  // Autotune length, -1 = not run or failed
+  NotifySink notify;
+};
+
+// A cut-down loop(): the same modules, wired the way main.cpp wires them,
+// with the plant standing in for the probes and the SSR
+class SimFirmware {
+public:
+  SimFirmware(const Scenario& scenario, uint32_t seed)
+      : sc(scenario), plant(scenario.plant, seed), menu(MENU_ITEMS, MENU_LENGTH),
+        saunaOn(false), heaterOn(false), nowMs(0), blockedUntilMs(0),
+        profile(SAMPLE_IDLE), nextSampleMs(0), tempF(scenario.plant.ambientF),
+        modelTempSum(0), modelDutySum(0), modelSamples(0), nextModelTickMs(1000), modelTicks(0) {
+    thermostat.setSetpoint(sc.setpointF);
+    thermostat.setGains(sc.gains);
+    memset(&notify, 0, sizeof(notify));
+    notify.stallEveryMs = sc.stallEveryMs;
+    notify.stallMs = sc.stallMs;
+    notify.blocking = sc.blockingNotify;
+  }
+
+  // Encoder script: Set, dial in the minutes, then Start
+  void startSession(int minutes) {
+    menu.rotate(2, 90);                       // "Set"
+    select();
+    menu.rotate(minutes, 120);
+    if (menu.press() == MENU_TIME_SET) countdown.set(menu.minutes() * 60000UL);
+    menu.rotate(-2, 90);                      // "Start"
+    select();
+  }
+
+  void startAutotune() {
+    if (!saunaOn) {
+      countdown.set(120 * 60000UL);
+      countdown.start(nowMs);
+      saunaOn = true;
+    }
+    autotune.start(sc.setpointF, nowMs);
+  }
+
+  // Runs for seconds of simulated time, scoring into result
+  void run(long seconds, Result& result) {
+    unsigned long endMs = nowMs + seconds * 1000UL;
+    unsigned long sessionStartMs = nowMs;
+    unsigned long holdStartMs = sessionStartMs + (sc.sessionMin * 60UL - SIM_HOLD_WINDOW_S) * 1000UL;
+    unsigned long heaterHoldMs = 0;
+    uint64_t heaterOnUs = 0;
+    double sqErrSum = 0;
+    long sqErrCount = 0;
+    float peakF = -1000.0f;
+    bool reached = false;
+
+    for (; nowMs < endMs; nowMs += SIM_STEP_MS) {
+      plant.step(heaterOn, SIM_STEP_MS / 1000.0f);
+      notify.service(nowMs);
+      if (heaterOn) heaterOnUs += SIM_STEP_MS * 1000UL;
+      if (nowMs >= holdStartMs && heaterOn) heaterHoldMs += SIM_STEP_MS;
+      if (nowMs < blockedUntilMs) continue;   // Stuck in a blocking POST; the SSR stays put
+
+      if (nowMs >= nextSampleMs) {
+        sample();
+        if (saunaOn) {
+          long sinceStart = (nowMs - sessionStartMs) / 1000;
+          if (!reached && tempF >= sc.setpointF - SIM_REACHED_BAND_F) {
+            reached = true;
+            result.timeToTargetS = sinceStart;
+          }
+          if (reached && tempF > peakF) peakF = tempF;
+          if (nowMs >= holdStartMs) {
+            sqErrSum += (tempF - sc.setpointF) * (tempF - sc.setpointF);
+            sqErrCount++;
+          }
+        }
+      }
+      if (nowMs >= nextModelTickMs) {
+        feedModel();
+        if (saunaOn && nowMs - sessionStartMs == 10 * 60000UL) {
+          result.etaAt10MinS = model.etaSeconds(tempF, sc.setpointF);
+        }
+      }
+
+      if (saunaOn && countdown.remainingMs() > 0 && countdown.update(nowMs)) {
+        saunaOn = false;
+        result.sessionS = (nowMs - sessionStartMs) / 1000;
+      }
+      uint32_t events = monitor.update(saunaOn, tempF, sc.setpointF, countdown.remainingMs(), SIM_WARN_MS);
+      if (events & SESSION_EVENT_ON) thermostat.reset(nowMs);
+      if (events & SESSION_EVENT_OFF) autotune.cancel();
+      for (int bit = 0; bit < 4; bit++) {
+        if (events & (1UL << bit)) blockedUntilMs = nowMs + notify.send(nowMs);
+      }
+      heaterOn = saunaOn && thermostat.heaterOn(nowMs);
+    }
+
+    result.overshootF = reached && peakF > sc.setpointF ? peakF - sc.setpointF : 0;
+    result.holdDuty = (float)heaterHoldMs / (SIM_HOLD_WINDOW_S * 1000.0f);
+    result.holdRmsF = sqErrCount > 0 ? sqrt(sqErrSum / sqErrCount) : 0;
+    result.kwh = energyKwh(heaterOnUs, sc.plant.heaterW);
+    result.gains = thermostat.getGains();
+    result.notify = notify;
+  }
+
+  // Leaves the session and lets the room cool back to ambient
+  void coolDown(long seconds) {
+    Result ignored;
+    saunaOn = false;
+    countdown.set(0);
+    run(seconds, ignored);
+  }
+
+  bool tuned() const { return autotune.getState() == AUTOTUNE_DONE; }
+  bool tuning() const { return autotune.getState() == AUTOTUNE_RUNNING; }
+  const Autotune& tuner() const { return autotune; }
+  void applyTunedGains() { thermostat.setGains(autotune.gains()); }
+  unsigned long now() const { return nowMs; }
+
+private:
+  void select() {
+    if (menu.press() != MENU_SELECTED) return;
+    if (strcmp(menu.label(), "Set") == 0 && !saunaOn) {
+      menu.beginSetTime();
+    } else if (strcmp(menu.label(), "Start") == 0 && !saunaOn && countdown.remainingMs() > 0) {
+      saunaOn = true;
+      countdown.start(nowMs);
+    }
+  }
+
+  // One probe reading, as serviceTemperature() handles it
+  void sample() {
+    tempF = plant.readF(profile.resolution);
+    if (autotune.getState() == AUTOTUNE_RUNNING) {
+      thermostat.setOutput(autotune.update(tempF, nowMs));
+    } else {
+      thermostat.update(tempF, nowMs);
+    }
+    profile = autotune.getState() == AUTOTUNE_RUNNING
+                  ? SAMPLE_HOLDING
+                  : chooseSampleProfile(profile, saunaOn, tempF, sc.setpointF);
+    if (profile.resolution > sc.maxResolution) profile.resolution = sc.maxResolution;
+    nextSampleMs = nowMs + profile.periodMs;
+  }
+
+  // The 1 s history tick's model feed, as feedThermalModel() does it
+  void feedModel() {
+    nextModelTickMs += 1000;
+    modelTempSum += tempF;
+    modelDutySum += heaterOn ? 1 : 0;
+    modelSamples++;
+    if (++modelTicks < THERMAL_STEP_S) return;
+    model.update(modelTempSum / modelSamples, (float)modelDutySum / modelSamples);
+    modelTempSum = 0;
+    modelDutySum = 0;
+    modelSamples = 0;
+    modelTicks = 0;
+  }
+
+  const Scenario& sc;
+  SaunaPlant plant;
+  Menu menu;
+  Countdown countdown;
+  SessionMonitor monitor;
+  Thermostat thermostat;
+  Autotune autotune;
+  ThermalModel model;
+  NotifySink notify;
+
+  bool saunaOn;
+  bool heaterOn;
+  unsigned long nowMs;
+  unsigned long blockedUntilMs;
+
+  SampleProfile profile;
+  unsigned long nextSampleMs;
+  float tempF;
+
+  float modelTempSum;
+  int modelDutySum;
+  int modelSamples;
+  unsigned long nextModelTickMs;
+  int modelTicks;
+};
+
+static Result runScenario(const Scenario& sc) {
+  Result result;
+  memset(&result, 0, sizeof(result));
+  result.timeToTargetS = -1;
+  result.etaAt10MinS = -1;
+  result.sessionS = -1;
+  result.tuneS = -1;
+
+  SimFirmware fw(sc, sc.seed);
+  if (sc.autotuneFirst) {
+    Result tuning;
+    memset(&tuning, 0, sizeof(tuning));
+    unsigned long start = fw.now();
+    fw.startAutotune();
+    while (fw.tuning()) fw.run(60, tuning);
+    if (fw.tuned()) {
+      result.tuneS = (fw.now() - start) / 1000;
+      fw.applyTunedGains();
+    }
+    fw.coolDown(6 * 3600);   // Back to a cold room for the scored session
+  }
+
+  fw.startSession(sc.sessionMin);
+  fw.run(sc.sessionMin * 60L + 300, result);   // Past the end, so queued messages can drain
+  return result;
+}
+
+static void printResult(const Scenario& sc, const Result& r) {
+  char ttt[24], eta[24];
+  if (r.timeToTargetS >= 0) {
+    snprintf(ttt, sizeof(ttt), "%ld:%02ld", r.timeToTargetS / 60, r.timeToTargetS % 60);
+  } else {
+    snprintf(ttt, sizeof(ttt), "never");
+  }
+  if (r.etaAt10MinS >= 0) {
+    snprintf(eta, sizeof(eta), "%ld:%02ld", (r.etaAt10MinS + 600) / 60, (r.etaAt10MinS + 600) % 60);
+  } else {
+    snprintf(eta, sizeof(eta), "-");
+  }
+  printf("%-26s %8s %9s %7.1f %6.1f%% %6.2f %6.2f %7ld %5u/%-3u %7.1f\n", sc.name, ttt, eta,
+         r.overshootF, r.holdDuty * 100.0f, r.holdRmsF, r.kwh, r.sessionS, r.notify.sent,
+         r.notify.dropped, r.notify.worstDelayMs / 1000.0f);
+  if (sc.autotuneFirst) {
+    printf("%-26s tuned in %ld s: Kp=%.3f Ki=%.5f Kd=%.2f\n", "", r.tuneS, r.gains.kp, r.gains.ki,
+           r.gains.kd);
+  }
+}
+
+// Prints a line per broken limit; returns how many there were
+static int checkResult(const Scenario& sc, const Result& r) {
+  const Limits& lim = sc.limits;
+  int failures = 0;
+  if (r.timeToTargetS < 0 || r.timeToTargetS > lim.maxTimeToTargetS) {
+    printf("FAIL %s: time to target %ld s, limit %ld s\n", sc.name, r.timeToTargetS,
+           lim.maxTimeToTargetS);
+    failures++;
+  }
+  if (r.overshootF > lim.maxOvershootF) {
+    printf("FAIL %s: overshoot %.1f F, limit %.1f F\n", sc.name, r.overshootF, lim.maxOvershootF);
+    failures++;
+  }
+  if (r.holdDuty > lim.maxHoldDuty) {
+    printf("FAIL %s: hold duty %.1f%%, limit %.1f%%\n", sc.name, r.holdDuty * 100.0f,
+           lim.maxHoldDuty * 100.0f);
+    failures++;
+  }
+  if (r.holdRmsF > lim.maxHoldRmsF) {
+    printf("FAIL %s: hold RMS %.2f F, limit %.2f F\n", sc.name, r.holdRmsF, lim.maxHoldRmsF);
+    failures++;
+  }
+  return failures;
+}
+
+// --- Benchmarks ---
+// Host figures, so only good for comparing one build against another
+static volatile float benchSink;
+
+template <typename F>
+static void bench(const char* name, long iterations, F body) {
+  auto start = std::chrono::steady_clock::now();
+  for (long i = 0; i < iterations; i++) body(i);
+  auto end = std::chrono::steady_clock::now();
+  double ns = std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+  printf("  %-34s %9.1f ns/call\n", name, ns);
+}
+
+static void runBenchmarks() {
+  printf("\nBenchmarks (host):\n");
+
+  Thermostat thermostat;
+  thermostat.setSetpoint(180.0f);
+  bench("Thermostat::update + heaterOn", 2000000, [&](long i) {
+    thermostat.update(175.0f + (i % 100) * 0.1f, i * 1000UL);
+    benchSink = thermostat.heaterOn(i * 1000UL);
+  });
+
+  Autotune autotune;
+  autotune.start(180.0f, 0);
+  bench("Autotune::update", 2000000, [&](long i) {
+    benchSink = autotune.update(180.0f + ((i / 50) % 2 ? 1.0f : -1.0f), i * 1000UL);
+  });
+
+  ThermalModel model;
+  bench("ThermalModel::update", 500000, [&](long i) {
+    model.update(100.0f + (i % 200) * 0.5f, (i % 3) / 2.0f);
+  });
+  bench("ThermalModel::etaSeconds", 500000, [&](long i) {
+    benchSink = model.etaSeconds(100.0f + (i % 50), 180.0f);
+  });
+
+  SampleProfile profile = SAMPLE_IDLE;
+  bench("chooseSampleProfile", 5000000, [&](long i) {
+    profile = chooseSampleProfile(profile, true, 150.0f + (i % 40), 180.0f);
+    benchSink = profile.resolution;
+  });
+
+  Countdown countdown;
+  countdown.set(90 * 60000UL);
+  countdown.start(0);
+  char buf[8];
+  bench("Countdown::update + format", 5000000, [&](long i) {
+    countdown.update(i);
+    countdown.format(buf, sizeof(buf));
+    benchSink = buf[4];
+  });
+
+  Menu menu(MENU_ITEMS, MENU_LENGTH);
+  bench("Menu::rotate", 10000000, [&](long i) {
+    menu.rotate(i % 3 - 1, 90);
+    benchSink = menu.label()[0];
+  });
+
+  SessionMonitor monitor;
+  bench("SessionMonitor::update", 10000000, [&](long i) {
+    benchSink = monitor.update((i / 1000) % 2, 170.0f + (i % 20), 180.0f, 900000 - i % 900000, SIM_WARN_MS);
+  });
+
+  static TempHistory history;
+  bench("TempHistory::add", 2000000, [&](long i) {
+    history.add(150.0f + (i % 60), true, i);
+  });
+}
+
+int main() {
+  PidGains defaults = { THERMOSTAT_DEFAULT_KP, THERMOSTAT_DEFAULT_KI, THERMOSTAT_DEFAULT_KD };
+  PidGains hysteresis = { 0, 0, 0 };
+  PlantParams plant = defaultPlant();
+  PlantParams noisy = defaultPlant();
+  noisy.noiseF = 0.5f;
+
+  //                  max target s  over F  duty   rms F
+  const Limits pidLimits = { 52 * 60,      2.0f,  0.50f, 0.5f };
+  const Scenario scenarios[] = {
+    { "PID, default gains",        plant, defaults,   false, 180.0f, 90, 12, 0, 0, false, 1,
+      pidLimits },
+    { "Hysteresis fallback",       plant, hysteresis, false, 180.0f, 90, 12, 0, 0, false, 1,
+      { 50 * 60, 3.5f, 0.50f, 2.5f } },
+    { "Autotuned PID",             plant, defaults,   true,  180.0f, 90, 12, 0, 0, false, 1,
+      { 56 * 60, 1.5f, 0.50f, 1.0f } },
+    { "PID, noisy 9-bit probe",    noisy, defaults,   false, 180.0f, 90,  9, 0, 0, false, 2,
+      { 53 * 60, 3.0f, 0.50f, 1.5f } },
+    { "PID, low setpoint",         plant, defaults,   false, 125.0f, 60, 12, 0, 0, false, 3,
+      { 26 * 60, 3.0f, 0.28f, 1.0f } },
+    // Notifications on their own task mustn't disturb control at all
+    { "Network stalls, queued",    plant, defaults,   false, 180.0f, 90, 12, 600000, 120000, false, 1,
+      pidLimits },
+    { "Network stalls, blocking",  plant, defaults,   false, 180.0f, 90, 12, 600000, 120000, true, 1,
+      { 55 * 60, 4.0f, 0.50f, 1.5f } },
+  };
+
+  printf("%-26s %8s %9s %7s %7s %6s %6s %7s %9s %7s\n", "Scenario", "target", "eta@10m",
+         "over F", "duty", "rms F", "kWh", "end s", "sent/drop", "worst s");
+  int failures = 0;
+  for (const Scenario& sc : scenarios) {
+    Result r = runScenario(sc);
+    printResult(sc, r);
+    failures += checkResult(sc, r);
+  }
+
+  runBenchmarks();
+  if (failures > 0) {
+    printf("\n%d limit(s) broken\n", failures);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include "autotune.h"
+
+// Relay output swings between 0 and 1, so its amplitude is half of that
+static const float RELAY_AMPLITUDE = 0.5f;
+static const float PI_F = 3.14159265f;
+
+Autotune::Autotune() : state(AUTOTUNE_IDLE), setpoint(0), relayHigh(false), startMs(0),
+                       cycles(0), ku(0), tu(0) {
+}
+
+void Autotune::start(float setpointF, unsigned long nowMs) {
+  state = AUTOTUNE_RUNNING;
+  setpoint = setpointF;
+  relayHigh = true;
+  startMs = nowMs;
+  minSeen = 1e9f;
+  maxSeen = -1e9f;
+  trough = 0;
+  haveTrough = false;
+  offSwitches = 0;
+  lastOffMs = nowMs;
+  cycles = 0;
+  amplitudeSum = 0;
+  amplitudeMin = 1e9f;
+  amplitudeMax = 0;
+  periods = 0;
+  periodSum = 0;
+}
+
+void Autotune::cancel() {
+  state = AUTOTUNE_IDLE;
+  relayHigh = false;
+  cycles = 0;
+}
+
+float Autotune::update(float tempF, unsigned long nowMs) {
+  if (state != AUTOTUNE_RUNNING) return 0;
+
+  if (nowMs - startMs >= AUTOTUNE_TIMEOUT_MS) {
+    state = AUTOTUNE_FAILED;   // Never settled into an oscillation
+    return 0;
+  }
+
+  if (relayHigh) {
+    if (tempF < minSeen) minSeen = tempF;
+    if (tempF <= setpoint + AUTOTUNE_NOISE_BAND_F) return 1.0f;
+
+    // Relay off.  The first on-phase is the climb from cold, so its
+    // "trough" is just the start temperature and the period it closes is
+    // stretched; both are skipped.
+    relayHigh = false;
+    offSwitches++;
+    if (offSwitches >= 2) {
+      trough = minSeen;
+      haveTrough = true;
+    }
+    if (offSwitches >= 3) {
+      periodSum += (nowMs - lastOffMs) / 1000.0f;
+      periods++;
+    }
+    lastOffMs = nowMs;
+    maxSeen = tempF;
+    return 0;
+  }
+
+  if (tempF > maxSeen) maxSeen = tempF;
+  if (tempF >= setpoint - AUTOTUNE_NOISE_BAND_F) return 0;
+
+  // Relay on.  One full cycle is a trough and the peak after it.
+  relayHigh = true;
+  if (haveTrough) {
+    float amplitude = (maxSeen - trough) / 2;
+    amplitudeSum += amplitude;
+    if (amplitude < amplitudeMin) amplitudeMin = amplitude;
+    if (amplitude > amplitudeMax) amplitudeMax = amplitude;
+    cycles++;
+  }
+  minSeen = tempF;
+
+  if (cycles >= AUTOTUNE_CYCLES && periods > 0) {
+    finish();
+    return 0;
+  }
+  return 1.0f;
+}
+
+void Autotune::finish() {
+  float amplitude = amplitudeSum / cycles;
+  tu = periodSum / periods;
+
+  bool consistent = amplitudeMax - amplitudeMin <= AUTOTUNE_MAX_SPREAD * amplitude;
+  if (amplitude <= 0 || tu <= 0 || !consistent) {
+    state = AUTOTUNE_FAILED;
+    return;
+  }
+
+  ku = 4 * RELAY_AMPLITUDE / (PI_F * amplitude);
+  state = AUTOTUNE_DONE;
+}
+
+// Tyreus-Luyben rules: a little slower than Ziegler-Nichols but with far
+// less overshoot, which matters more for a room full of people
+PidGains Autotune::gains() const {
+  float kp = ku / 2.2f;
+  float ti = 2.2f * tu;
+  float td = tu / 6.3f;
+  PidGains pid = { kp, kp / ti, kp * td };
+  return pid;
+}
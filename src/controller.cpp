@@ -0,0 +1,73 @@
+#include "controller.h"
+#include "wake.h"
+
+static QueueHandle_t commandQueue = NULL;
+static QueueHandle_t settingQueue = NULL;
+
+// --- Snapshot publication ---
+// The writer fills the buffer readers aren't using, then bumps seq; the
+// buffer for publish n is snapshots[n & 1].  A reader copies the current
+// one and keeps it only if seq didn't move meanwhile, i.e. the writer
+// never started on the buffer being copied.
+static ControllerSnapshot snapshots[2];
+static volatile uint32_t seq = 0;
+
+void controllerBegin() {
+  if (commandQueue != NULL) return;
+  commandQueue = xQueueCreate(COMMAND_QUEUE_LENGTH, sizeof(Command));
+  settingQueue = xQueueCreate(SETTING_QUEUE_LENGTH, sizeof(SettingChange));
+  memset(snapshots, 0, sizeof(snapshots));
+}
+
+bool postCommand(CommandType type, CommandSource source, float value) {
+  Command command = {};
+  command.type = type;
+  command.source = source;
+  command.value = value;
+  return postCommand(command);
+}
+
+bool postCommand(const Command& command) {
+  if (commandQueue == NULL) return false;
+  if (xQueueSend(commandQueue, &command, 0) != pdTRUE) return false;
+  wakeLoop(WAKE_COMMAND);
+  return true;
+}
+
+bool pollCommand(Command& command) {
+  if (commandQueue == NULL) return false;
+  return xQueueReceive(commandQueue, &command, 0) == pdTRUE;
+}
+
+bool postSetting(int index, const char* text) {
+  if (settingQueue == NULL || !settingValid(index, text)) return false;
+
+  SettingChange change;
+  change.index = index;
+  strlcpy(change.text, text, sizeof(change.text));
+  if (xQueueSend(settingQueue, &change, 0) != pdTRUE) return false;
+  wakeLoop(WAKE_COMMAND);
+  return true;
+}
+
+bool pollSetting(SettingChange& change) {
+  if (settingQueue == NULL) return false;
+  return xQueueReceive(settingQueue, &change, 0) == pdTRUE;
+}
+
+void publishSnapshot(const ControllerSnapshot& snapshot) {
+  uint32_t next = seq + 1;
+  snapshots[next & 1] = snapshot;
+  __sync_synchronize();   // Contents visible on the other core before seq
+  seq = next;
+}
+
+void readSnapshot(ControllerSnapshot& snapshot) {
+  uint32_t before;
+  do {
+    before = seq;
+    __sync_synchronize();
+    snapshot = snapshots[before & 1];
+    __sync_synchronize();
+  } while (seq != before);
+}
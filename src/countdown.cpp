@@ -0,0 +1,19 @@
+#include <stdio.h>
+#include "countdown.h"
+
+void Countdown::add(unsigned long ms, unsigned long capMs, unsigned long nowMs) {
+  remaining = remaining + ms > capMs ? capMs : remaining + ms;
+  deadline = nowMs + remaining;
+}
+
+bool Countdown::update(unsigned long nowMs) {
+  // Signed difference so a deadline just passed reads as expired
+  long left = (long)(deadline - nowMs);
+  remaining = left > 0 ? left : 0;
+  return remaining == 0;
+}
+
+void Countdown::format(char* buf, size_t len) const {
+  unsigned long secsLeft = remaining / 1000;
+  snprintf(buf, len, "%02lu:%02lu", secsLeft / 60, secsLeft % 60);
+}
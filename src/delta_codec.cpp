@@ -0,0 +1,48 @@
+#include "delta_codec.h"
+
+static uint32_t zigzag(int32_t value) {
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value) {
+  return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+size_t DeltaEncoder::encode(int16_t centiF, uint8_t* out) {
+  if (centiF == DELTA_GAP) {
+    out[0] = 0;
+    return 1;
+  }
+
+  uint32_t value = zigzag((int32_t)centiF - last) + 1;
+  last = centiF;
+
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+size_t DeltaDecoder::decode(const uint8_t* in, size_t len, int16_t& centiF) {
+  uint32_t value = 0;
+  size_t n = 0;
+  int shift = 0;
+  for (;;) {
+    if (n >= len || n >= DELTA_MAX_BYTES) return 0;
+    uint8_t b = in[n++];
+    value |= (uint32_t)(b & 0x7f) << shift;
+    if (!(b & 0x80)) break;
+    shift += 7;
+  }
+
+  if (value == 0) {
+    centiF = DELTA_GAP;
+  } else {
+    last = (int16_t)(last + unzigzag(value - 1));
+    centiF = last;
+  }
+  return n;
+}
@@ -0,0 +1,165 @@
+#include <Wire.h>
+#include <LiquidCrystal_I2C.h>
+#include "display.h"
+
+// === LCD setup ===
+// Only the display task touches these after displayBegin()
+static LiquidCrystal_I2C lcd(0x27, LCD_COLS, LCD_ROWS);  // Adjust I2C address if needed
+static LcdFrame frame(lcd);                               // Only changed cells go out over I2C
+
+// --- Flame character ---
+static byte flameChar[8] = {
+  B00100,
+  B00101,
+  B00101,
+  B10111,
+  B10111,
+  B11111,
+  B11110,
+  B01110
+};
+
+struct DisplayOverlay {
+  char line1[LCD_COLS + 1];
+  char line2[LCD_COLS + 1];
+  unsigned long durationMs;   // 0 = until cleared
+  bool clear;
+};
+
+// --- Render queues ---
+// Length-1 mailboxes written with xQueueOverwrite: a slow LCD only ever
+// skips stale frames, it never backs up the producer.
+static QueueHandle_t stateBox = NULL;
+static QueueHandle_t overlayBox = NULL;
+static TaskHandle_t displayTaskHandle = NULL;
+static volatile bool wantAwake = true;
+
+static void renderStatus(const DisplayState& state) {
+  char text[LCD_COLS + 1];
+
+  // Line 1: Temperature, Timer and flame or underscore at (15, 0)
+  snprintf(text, sizeof(text), "%.1f%cF", state.tempF, (char)223); // Degree symbol
+  frame.print(0, 0, text);
+  frame.print(8, 0, state.timeRemaining);
+  frame.putChar(15, 0, state.saunaOn ? 0 : '_');   // 0 = flame icon
+
+  // Line 2: Menu or Time Setting (the cleared frame takes care of padding)
+  if (state.isSettingTime) {
+    snprintf(text, sizeof(text), ">Set Time: %2dm", state.setMinutes);
+  } else {
+    snprintf(text, sizeof(text), ">%s", state.menuLabel);
+  }
+  frame.print(0, 1, text);
+
+  // Predicted heat-up time, right-aligned after the menu label
+  if (!state.isSettingTime && state.etaMinutes >= 0) {
+    snprintf(text, sizeof(text), "~%3dm", min(state.etaMinutes, 999));
+    frame.print(LCD_COLS - 5, 1, text);
+  }
+}
+
+static void displayTask(void* param) {
+  DisplayState state;
+  bool haveState = false;
+  DisplayOverlay overlay;
+  bool overlayActive = false;
+  unsigned long overlayStart = 0;
+  bool awake = true;
+
+  for (;;) {
+    // Sleep until someone queues something, or the overlay runs out
+    TickType_t wait = portMAX_DELAY;
+    if (overlayActive && overlay.durationMs > 0) {
+      unsigned long elapsed = millis() - overlayStart;
+      wait = elapsed >= overlay.durationMs ? 0 : pdMS_TO_TICKS(overlay.durationMs - elapsed);
+    }
+    ulTaskNotifyTake(pdTRUE, wait);
+
+    DisplayOverlay incoming;
+    if (xQueueReceive(overlayBox, &incoming, 0) == pdTRUE) {
+      overlay = incoming;
+      overlayActive = !incoming.clear;
+      overlayStart = millis();
+    }
+    if (overlayActive && overlay.durationMs > 0 &&
+        millis() - overlayStart >= overlay.durationMs) {
+      overlayActive = false;
+    }
+    if (xQueueReceive(stateBox, &state, 0) == pdTRUE) {
+      haveState = true;
+    }
+
+    // Asleep, nothing goes out over I2C until the backlight comes back
+    if (wantAwake != awake) {
+      awake = wantAwake;
+      if (awake) {
+        lcd.backlight();
+        frame.invalidate();   // Redraw every cell, whatever the LCD holds
+      } else {
+        lcd.noBacklight();
+      }
+    }
+    if (!awake) continue;
+
+    frame.clear();
+    if (overlayActive) {
+      frame.print(0, 0, overlay.line1);
+      frame.print(0, 1, overlay.line2);
+    } else if (haveState) {
+      renderStatus(state);
+    }
+    frame.flush();
+  }
+}
+
+void displayBegin() {
+  if (displayTaskHandle != NULL) return;
+
+  lcd.init();
+  Wire.setClock(LCD_I2C_CLOCK);
+  lcd.backlight();
+  lcd.createChar(0, flameChar);
+  lcd.clear();
+  frame.invalidate();
+
+  stateBox = xQueueCreate(1, sizeof(DisplayState));
+  overlayBox = xQueueCreate(1, sizeof(DisplayOverlay));
+  xTaskCreatePinnedToCore(displayTask, "display", DISPLAY_TASK_STACK, NULL,
+                          DISPLAY_TASK_PRIORITY, &displayTaskHandle, DISPLAY_TASK_CORE);
+}
+
+void displayUpdate(const DisplayState& state) {
+  if (displayTaskHandle == NULL) return;
+  xQueueOverwrite(stateBox, &state);
+  xTaskNotifyGive(displayTaskHandle);
+}
+
+void displayOverlay(const char* line1, const char* line2, unsigned long durationMs) {
+  if (displayTaskHandle == NULL) return;
+
+  DisplayOverlay overlay;
+  strlcpy(overlay.line1, line1, sizeof(overlay.line1));
+  strlcpy(overlay.line2, line2, sizeof(overlay.line2));
+  overlay.durationMs = durationMs;
+  overlay.clear = false;
+  xQueueOverwrite(overlayBox, &overlay);
+  xTaskNotifyGive(displayTaskHandle);
+}
+
+void displayClearOverlay() {
+  if (displayTaskHandle == NULL) return;
+
+  DisplayOverlay overlay;
+  overlay.line1[0] = '\0';
+  overlay.line2[0] = '\0';
+  overlay.durationMs = 0;
+  overlay.clear = true;
+  xQueueOverwrite(overlayBox, &overlay);
+  xTaskNotifyGive(displayTaskHandle);
+}
+
+void displaySetAwake(bool awake) {
+  if (displayTaskHandle == NULL || wantAwake == awake) return;
+  wantAwake = awake;
+  xTaskNotifyGive(displayTaskHandle);
+}
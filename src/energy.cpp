@@ -0,0 +1,46 @@
+#include "energy.h"
+
+float energyKwh(uint64_t onUs, float watts) {
+  return (float)((double)onUs * watts / 3.6e12);   // µs·W -> kWh
+}
+
+EnergyMeter::EnergyMeter() : lastTotalUs(0), heldUs(0) {
+  day.key = ENERGY_NO_KEY;
+  day.onUs = 0;
+  month = day;
+}
+
+void EnergyMeter::restore(int32_t dayKey, uint64_t dayUs, int32_t monthKey, uint64_t monthUs,
+                          uint64_t heldUs) {
+  this->heldUs = heldUs;
+  day.key = dayKey;
+  day.onUs = dayUs;
+  month.key = monthKey;
+  month.onUs = monthUs;
+}
+
+// A period saved before the clock was ever set is adopted by the first
+// real date rather than thrown away
+void EnergyMeter::roll(Period& period, int32_t key) {
+  if (key == period.key) return;
+  if (period.key != ENERGY_NO_KEY) period.onUs = 0;
+  period.key = key;
+}
+
+void EnergyMeter::update(uint64_t totalOnUs, int32_t dayKey, int32_t monthKey) {
+  // The total counts from zero at boot; on-time before that is in the restore
+  uint64_t delta = totalOnUs > lastTotalUs ? totalOnUs - lastTotalUs : 0;
+  lastTotalUs = totalOnUs;
+
+  // No date yet: nothing to say which period this belongs to
+  if (dayKey == ENERGY_NO_KEY || monthKey == ENERGY_NO_KEY) {
+    heldUs += delta;
+    return;
+  }
+
+  roll(day, dayKey);
+  roll(month, monthKey);
+  day.onUs += delta + heldUs;
+  month.onUs += delta + heldUs;
+  heldUs = 0;
+}
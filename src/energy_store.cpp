@@ -0,0 +1,33 @@
+#include <Preferences.h>
+#include "energy_store.h"
+
+#define ENERGY_NAMESPACE "energy"
+
+bool loadEnergy(EnergyMeter& meter) {
+  Preferences prefs;
+  if (!prefs.begin(ENERGY_NAMESPACE, true)) return false;   // Read-only
+
+  bool found = prefs.isKey("day") && prefs.isKey("dayUs") &&
+               prefs.isKey("month") && prefs.isKey("monthUs");
+  if (found) {
+    meter.restore(prefs.getInt("day"), prefs.getULong64("dayUs"),
+                  prefs.getInt("month"), prefs.getULong64("monthUs"),
+                  prefs.getULong64("heldUs", 0));
+  }
+  prefs.end();
+  return found;
+}
+
+void saveEnergy(const EnergyMeter& meter) {
+  Preferences prefs;
+  if (!prefs.begin(ENERGY_NAMESPACE, false)) {
+    Serial.println("Could not open NVS to save energy totals.");
+    return;
+  }
+  prefs.putInt("day", meter.dayKey());
+  prefs.putULong64("dayUs", meter.dayOnUs());
+  prefs.putInt("month", meter.monthKey());
+  prefs.putULong64("monthUs", meter.monthOnUs());
+  prefs.putULong64("heldUs", meter.heldOnUs());
+  prefs.end();
+}
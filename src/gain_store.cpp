@@ -0,0 +1,30 @@
+#include <Preferences.h>
+#include "gain_store.h"
+
+#define GAIN_NAMESPACE "thermostat"
+
+bool loadGains(PidGains& gains) {
+  Preferences prefs;
+  if (!prefs.begin(GAIN_NAMESPACE, true)) return false;   // Read-only
+
+  bool found = prefs.isKey("kp") && prefs.isKey("ki") && prefs.isKey("kd");
+  if (found) {
+    gains.kp = prefs.getFloat("kp");
+    gains.ki = prefs.getFloat("ki");
+    gains.kd = prefs.getFloat("kd");
+  }
+  prefs.end();
+  return found;
+}
+
+void saveGains(const PidGains& gains) {
+  Preferences prefs;
+  if (!prefs.begin(GAIN_NAMESPACE, false)) {
+    Serial.println("Could not open NVS to save PID gains.");
+    return;
+  }
+  prefs.putFloat("kp", gains.kp);
+  prefs.putFloat("ki", gains.ki);
+  prefs.putFloat("kd", gains.kd);
+  prefs.end();
+}
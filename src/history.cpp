@@ -0,0 +1,77 @@
+#include "history.h"
+
+TempHistory::TempHistory() {
+  uint16_t next = 0;
+  for (int tier = 0; tier < HISTORY_TIERS; tier++) {
+    offset[tier] = next;
+    next += HISTORY_CAPACITY[tier];
+    tierWritten[tier] = 0;
+    tierNewestS[tier] = 0;
+    sum[tier] = 0;
+    validCount[tier] = 0;
+    pending[tier] = 0;
+  }
+}
+
+uint16_t TempHistory::count(int tier) const {
+  // The oldest slot of a full ring is the next one written, so it's never
+  // offered; read() would refuse it
+  uint32_t n = tierWritten[tier];
+  return n < HISTORY_CAPACITY[tier] ? n : HISTORY_CAPACITY[tier] - 1;
+}
+
+void TempHistory::add(float tempF, bool valid, uint32_t uptimeS) {
+  int16_t centiF = HISTORY_NO_SAMPLE;
+  if (valid) {
+    float centi = tempF * 100;
+    if (centi > INT16_MAX) centi = INT16_MAX;
+    if (centi < INT16_MIN + 1) centi = INT16_MIN + 1;
+    centiF = (int16_t)(centi + (centi >= 0 ? 0.5f : -0.5f));
+  }
+  push(0, centiF, uptimeS);
+}
+
+void TempHistory::push(int tier, int16_t centiF, uint32_t uptimeS) {
+  uint32_t seq = tierWritten[tier];
+  samples[offset[tier] + seq % HISTORY_CAPACITY[tier]] = centiF;
+  tierNewestS[tier] = uptimeS;
+  __sync_synchronize();
+  tierWritten[tier] = seq + 1;   // Publish only after the sample is stored
+
+  if (tier + 1 >= HISTORY_TIERS) return;
+
+  // Average this tier's samples into one of the next (gaps don't count)
+  if (centiF != HISTORY_NO_SAMPLE) {
+    sum[tier] += centiF;
+    validCount[tier]++;
+  }
+  pending[tier]++;
+
+  uint16_t ratio = HISTORY_INTERVAL_S[tier + 1] / HISTORY_INTERVAL_S[tier];
+  if (pending[tier] >= ratio) {
+    int16_t average = HISTORY_NO_SAMPLE;
+    if (validCount[tier] > 0) {
+      average = (int16_t)(sum[tier] / validCount[tier]);
+    }
+    sum[tier] = 0;
+    validCount[tier] = 0;
+    pending[tier] = 0;
+    push(tier + 1, average, uptimeS);
+  }
+}
+
+bool TempHistory::read(int tier, uint32_t seq, int16_t& centiF) const {
+  uint16_t capacity = HISTORY_CAPACITY[tier];
+  uint32_t before = tierWritten[tier];
+  if (seq >= before || before - seq >= capacity) return false;
+
+  __sync_synchronize();
+  centiF = samples[offset[tier] + seq % capacity];
+  __sync_synchronize();
+
+  // The writer may have lapped us while we read.  Once written reaches
+  // seq + capacity the slot is being (or has been) overwritten by that
+  // sample, whether or not it's published yet.
+  uint32_t after = tierWritten[tier];
+  return after - seq < capacity;
+}
@@ -0,0 +1,139 @@
+#include <ESP32Encoder.h>
+#include "input.h"
+#include "wake.h"
+
+// What woke the input task, as notification bits
+#define EDGE_SWITCH  (1UL << 0)
+#define EDGE_ENCODER (1UL << 1)
+
+static TaskHandle_t inputTaskHandle = NULL;
+
+static void IRAM_ATTR notifyFromIsr(uint32_t bits) {
+  if (inputTaskHandle == NULL) return;
+  BaseType_t woken = pdFALSE;
+  xTaskNotifyFromISR(inputTaskHandle, bits, eSetBits, &woken);
+  if (woken) portYIELD_FROM_ISR();
+}
+
+// Called by the encoder's PCNT interrupt on every count
+static void IRAM_ATTR encoderIsr(void* arg) {
+  notifyFromIsr(EDGE_ENCODER);
+}
+
+// Only wakes the task; all debouncing happens there
+static void IRAM_ATTR switchIsr() {
+  notifyFromIsr(EDGE_SWITCH);
+}
+
+static ESP32Encoder encoder(true, encoderIsr);   // true = interrupt on every count
+static int switchPin = -1;
+static QueueHandle_t inputQueue = NULL;
+
+// Rounds toward negative infinity so the click around zero isn't twice as wide
+static int32_t countToDetent(int64_t count) {
+  if (count >= 0) return count / ENCODER_COUNTS_PER_DETENT;
+  return -((-count + ENCODER_COUNTS_PER_DETENT - 1) / ENCODER_COUNTS_PER_DETENT);
+}
+
+static bool postEvent(InputEventType type, int32_t delta, int64_t timestampUs) {
+  InputEvent event = { type, delta, timestampUs };
+  if (xQueueSend(inputQueue, &event, 0) != pdTRUE) return false;
+  wakeLoop(WAKE_INPUT);
+  return true;
+}
+
+// Ticks until deadlineUs, rounded up so the wait never ends early
+static TickType_t ticksUntil(int64_t deadlineUs, int64_t nowUs) {
+  if (deadlineUs <= nowUs) return 0;
+  return pdMS_TO_TICKS((deadlineUs - nowUs + 999) / 1000) + 1;
+}
+
+static void inputTask(void* param) {
+  int32_t lastDetent = countToDetent(encoder.getCount());
+  int32_t pendingDelta = 0;
+
+  bool stablePressed = false;
+  bool debouncing = false;
+  bool longPressSent = false;
+  int64_t lastEdgeUs = 0;
+  int64_t pressStartUs = 0;
+  TickType_t wait = portMAX_DELAY;
+
+  for (;;) {
+    uint32_t edges = 0;
+    xTaskNotifyWait(0, ULONG_MAX, &edges, wait);
+    int64_t now = esp_timer_get_time();
+
+    // --- Rotation ---
+    // PCNT keeps counting no matter how late we are; if the queue is full
+    // the turn is held back and merged into the next event.
+    int32_t detent = countToDetent(encoder.getCount());
+    pendingDelta += detent - lastDetent;
+    lastDetent = detent;
+    if (pendingDelta != 0 && postEvent(INPUT_ROTATE, pendingDelta, now)) {
+      pendingDelta = 0;
+    }
+
+    // --- Switch ---
+    // Every bounce restarts the debounce window
+    if (edges & EDGE_SWITCH) {
+      lastEdgeUs = now;
+      debouncing = true;
+    }
+
+    if (debouncing && now - lastEdgeUs >= INPUT_DEBOUNCE_MS * 1000LL) {
+      debouncing = false;
+      bool pressed = digitalRead(switchPin) == LOW;
+      if (pressed != stablePressed) {
+        stablePressed = pressed;
+        if (pressed) {
+          pressStartUs = lastEdgeUs;
+          longPressSent = false;
+        } else if (!longPressSent) {
+          postEvent(INPUT_PRESS, 0, pressStartUs);
+        }
+      }
+    }
+
+    if (stablePressed && !longPressSent &&
+        now - pressStartUs >= INPUT_LONG_PRESS_MS * 1000LL) {
+      longPressSent = postEvent(INPUT_LONG_PRESS, 0, now);
+    }
+
+    // --- Next wake ---
+    // Only a running debounce, a press being timed or a held-back turn
+    // needs a timeout; otherwise sleep until the next edge
+    wait = portMAX_DELAY;
+    if (debouncing) {
+      wait = min(wait, ticksUntil(lastEdgeUs + INPUT_DEBOUNCE_MS * 1000LL, now));
+    }
+    if (stablePressed && !longPressSent) {
+      wait = min(wait, ticksUntil(pressStartUs + INPUT_LONG_PRESS_MS * 1000LL, now));
+    }
+    if (pendingDelta != 0) {
+      wait = min(wait, (TickType_t)pdMS_TO_TICKS(INPUT_RETRY_MS));
+    }
+  }
+}
+
+void inputBegin(int pinA, int pinB, int pinSwitch) {
+  if (inputTaskHandle != NULL) return;
+
+  switchPin = pinSwitch;
+  pinMode(switchPin, INPUT_PULLUP);
+
+  inputQueue = xQueueCreate(INPUT_QUEUE_LENGTH, sizeof(InputEvent));
+  xTaskCreatePinnedToCore(inputTask, "input", INPUT_TASK_STACK, NULL,
+                          INPUT_TASK_PRIORITY, &inputTaskHandle, INPUT_TASK_CORE);
+
+  // Attach only once the task exists, since both ISRs notify it
+  encoder.attachFullQuad(pinA, pinB);
+  encoder.setFilter(ENCODER_FILTER);
+  encoder.clearCount();
+  attachInterrupt(digitalPinToInterrupt(switchPin), switchIsr, CHANGE);
+}
+
+bool inputPoll(InputEvent& event) {
+  if (inputQueue == NULL) return false;
+  return xQueueReceive(inputQueue, &event, 0) == pdTRUE;
+}
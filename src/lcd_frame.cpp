@@ -0,0 +1,58 @@
+#include "lcd_frame.h"
+
+LcdFrame::LcdFrame(LiquidCrystal_I2C& lcd) : lcd(lcd), frontValid(false) {
+  clear();
+}
+
+void LcdFrame::clear() {
+  memset(back, ' ', sizeof(back));
+}
+
+void LcdFrame::print(uint8_t col, uint8_t row, const char* text) {
+  if (row >= LCD_ROWS) return;
+  for (; *text && col < LCD_COLS; text++, col++) {
+    back[row][col] = (uint8_t)*text;
+  }
+}
+
+void LcdFrame::putChar(uint8_t col, uint8_t row, uint8_t c) {
+  if (row >= LCD_ROWS || col >= LCD_COLS) return;
+  back[row][col] = c;
+}
+
+int LcdFrame::flush() {
+  int written = 0;
+
+  for (uint8_t row = 0; row < LCD_ROWS; row++) {
+    uint8_t col = 0;
+    while (col < LCD_COLS) {
+      if (frontValid && front[row][col] == back[row][col]) {
+        col++;
+        continue;
+      }
+
+      // Write one run of changed cells; the LCD advances the cursor itself.
+      // A single unchanged cell inside a run is rewritten, since that costs
+      // the same as the setCursor() it saves.
+      lcd.setCursor(col, row);
+      while (col < LCD_COLS) {
+        bool changed = !frontValid || front[row][col] != back[row][col];
+        bool nextChanged = col + 1 < LCD_COLS &&
+                           (!frontValid || front[row][col + 1] != back[row][col + 1]);
+        if (!changed && !nextChanged) break;
+
+        lcd.write(back[row][col]);
+        front[row][col] = back[row][col];
+        written++;
+        col++;
+      }
+    }
+  }
+
+  frontValid = true;
+  return written;
+}
+
+void LcdFrame::invalidate() {
+  frontValid = false;
+}
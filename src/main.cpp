@@ -1,12 +1,38 @@
-#include <Wire.h>
-#include <LiquidCrystal_I2C.h>
-#include <OneWire.h>
-#include <DallasTemperature.h>
 #include <WiFi.h>
-#include <WebServer.h>
-#include <ESP32Encoder.h>
+#include <ESPAsyncWebServer.h>
 #include <secrets.h>
-#include <HTTPClient.h>
+#include <esp_timer.h>
+#include <memory>
+#include <new>
+#include "notifier.h"
+#include "wifi_manager.h"
+#include "mqtt_bridge.h"
+#include "safety.h"
+#include "ota.h"
+#include "display.h"
+#include "probes.h"
+#include "sample_profile.h"
+#include "history.h"
+#include "delta_codec.h"
+#include "input.h"
+#include "menu.h"
+#include "countdown.h"
+#include "session_monitor.h"
+#include "wake.h"
+#include "controller.h"
+#include "thermostat.h"
+#include "autotune.h"
+#include "gain_store.h"
+#include "session_log.h"
+#include "energy.h"
+#include "energy_store.h"
+#include "thermal_model.h"
+#include "schedule.h"
+#include "schedule_store.h"
+#include "settings.h"
+#include "perf.h"
+#include "index_html_gz.h"    // Generated from web/*.html by scripts/embed_web.py
+#include "config_html_gz.h"
 
 // Author:  Steven Morrow & Patrick Morrow
 // Date:    05/11/2025
@@ -35,524 +61,1816 @@
 //#define LCD_SDA 21
 //#define LCD_SCL 22
 
-// === LCD and sensor setup ===
-LiquidCrystal_I2C lcd(0x27, 16, 2);  // Adjust I2C address if needed
-OneWire oneWire(ONE_WIRE_BUS);
-DallasTemperature sensors(&oneWire);
-
-// --- Encoder Setup ---
-ESP32Encoder encoder;
-int lastPosition = 0;
-
 // -- Webserver ---
-WebServer server(80);
-
-// --- Flame character ---
-byte flameChar[8] = {
-  B00100,
-  B00101,
-  B00101,
-  B10111,
-  B10111,
-  B11111,
-  B11110,
-  B01110
+// Handlers run on the AsyncTCP task, not in loop(), so every request is
+// answered right away even while loop() is busy.
+AsyncWebServer server(80);
+AsyncEventSource events("/events");   // Pushes status changes to browsers
+
+// --- Timing probes, reported on /metrics ---
+int loopProbe = -1;
+int displayProbe = -1;
+int tempReadProbe = -1;
+
+// Tasks whose stack headroom /metrics reports; missing ones are skipped
+const char* const METRICS_TASKS[] = {
+  "loopTask", "async_tcp", "input", "display", "safety", "notifier", "wifi", "mqtt", "sessionlog"
 };
 
 // --- Menu options ---
-const char* menuItems[] = {"Start", "Stop", "Set", "IP"};
-const int menuLength = 4;
-int menuIndex = 0;
+const char* menuItems[] = {"Start", "Stop", "Set", "Tune", "Sched", "Temps", "Probes", "IP", "Settings"};
+const int menuLength = 9;
+Menu menu(menuItems, menuLength);
 
-// === WiFi Info ===
-// *Use secrets.h file to define primary and secondary WiFi credentials
-unsigned long wifiTimeout = 20000; // 20 seconds in milliseconds
+// --- Encoder "Settings" menu ---
+int settingsItem = -1;       // Which of the menu-editable settings, -1 = not in the menu
+bool editingSetting = false;
+float editValue = 0;
 
-// --- Timing ---
-unsigned long lastTempRead = 0;
-unsigned long lastLCDUpdate = 0;
+// --- Encoder "Probes" menu ---
+int probeItem = -1;          // Which probe is shown, -1 = not in the menu
+bool editingRole = false;
+int editRole = PROBE_UNASSIGNED;
 
-// --- Button state tracking ---
-bool lastButtonState = HIGH;
+// --- Timing ---
+// loop() blocks until one of these timers (or input / a web command) wakes it
+const unsigned long LOOP_IDLE_MAX_MS = 1000;    // Backstop in case a wake is missed
+TimerHandle_t tempTimer;
+TimerHandle_t countdownTimer;
+
+// --- Idle power mode ---
+const uint32_t IDLE_CPU_MHZ = 80;               // Lowest clock WiFi still runs at
+// Longer than SAFETY_SENSOR_TIMEOUT_MS on purpose: that check only runs in
+// a session, and restarts its count when one begins (leaveIdle() has a
+// conversion under way by then)
+const unsigned long IDLE_SAMPLE_MS = 60000;     // Enough to catch a stuck-on SSR
+bool idle = false;
+unsigned long lastActivityMs = 0;               // Last input, command or session
+uint32_t awakeCpuMhz = 0;                       // Clock to go back to
+
+// --- Fixed text buffers (keep the hot paths off the heap) ---
+#define TIME_STR_LEN 8        // "mm:ss" plus headroom
+#define STATUS_JSON_LEN 2048  // Largest /status payload, diagnostics included
+#define LIVE_JSON_LEN 256     // The live fields /events sends
+#define SCHEDULE_JSON_LEN 1536  // /schedule with every slot in use
 
 // === STATE ===
+// Owned by loop(); other tasks post commands and read the snapshot
 bool saunaOn = false;
-bool lastSaunaState = false;
-bool isSettingTime = false;
-int setMinutes = 0;
-unsigned long countdownMillis = 0;
-unsigned long targetTime = 0;
-String strTimeRemaining = "";
+Countdown countdown;            // Preset while off, counting down while on
+SessionMonitor sessionMonitor;  // On/off and "reached" notifications
+char strTimeRemaining[TIME_STR_LEN] = "00:00";
 
 // === CONSTANTS ===
-const int MAX_TIME = 90;  // 1 hour 30 minutes
+// Session lengths, the add-time step and the boot setpoint live in settings
 const unsigned long IP_DISPLAY_TIME = 4000; // 4 seconds
 
 // --- Temperature ---
-DeviceAddress sensorAddress;
-float currentTempF = 0.0;
+float currentTempF = 0.0;               // Control (bench) probe
 bool tempConversionInProgress = false;
+bool sensorFaultNotified = false;      // Latched until a good reading
+bool noBenchNotified = false;          // Latched until a probe holds the bench role
 unsigned long tempRequestTime = 0;
-const float targetTempF = 125.0;        // Target temperature for discord notification
-bool targetTempOneshotSent = false;
+SampleProfile sampleProfile = SAMPLE_IDLE;  // Resolution and rate, adapted per reading
+
+// --- Temperature history ---
+TempHistory history;    // 1 s / 10 s / 1 min tiers, served on /history
+TimerHandle_t historyTimer;
+float targetTempF = 125.0;              // Thermostat setpoint, also the "reached" threshold
 
-// Sends a notfication message to discord
-void sendDiscordNotification(String message) {
-  if (WiFi.status() == WL_CONNECTED) {
-    HTTPClient http;
-    http.begin(DISCORD_WEBHOOK_URL);
-    http.addHeader("Content-Type", "application/json");
+// Re-arms a one-shot timer to fire after ms (at least one tick)
+void armTimer(TimerHandle_t timer, unsigned long ms) {
+  TickType_t ticks = pdMS_TO_TICKS(ms);
+  xTimerChangePeriod(timer, ticks > 0 ? ticks : 1, 0);
+}
 
-    String payload = "{\"content\": \"" + message + "\"}";
-    int httpResponseCode = http.POST(payload);
+// --- Heater control ---
+// saunaOn is the session; the thermostat decides when the SSR conducts
+Thermostat thermostat;
+Autotune autotune;      // Takes over the SSR from the thermostat while running
+bool heaterOn = false;
+TimerHandle_t heaterTimer;
+
+// --- Heat-up prediction ---
+ThermalModel thermalModel;      // Fitted from 1 s samples averaged over THERMAL_STEP_S
+float modelTempSum = 0;
+int modelDutySum = 0;
+int modelSamples = 0;
+int modelTicks = 0;
+
+// --- Wall clock and scheduled starts ---
+// SNTP runs in the background once WiFi is up; until it syncs only weekly
+// entries can be added and nothing scheduled fires
+#ifndef TIME_ZONE
+#define TIME_ZONE "UTC0"   // POSIX TZ, override in secrets.h (e.g. "EST5EDT,M3.2.0,M11.1.0")
+#endif
+#define NTP_SERVER_1 "pool.ntp.org"
+#define NTP_SERVER_2 "time.nist.gov"
+const long PREHEAT_DEFAULT_MIN = 45;   // Until the thermal model has converged
+const long PREHEAT_MARGIN_MIN = 5;     // Extra on top of the model's ETA
+const long PREHEAT_MAX_MIN = 60;
+Scheduler scheduler;                   // loop() only; handlers see the snapshot
+
+// --- Current session, written to the session log when it ends ---
+unsigned long sessionStartMs = 0;
+float sessionPeakF = DEVICE_DISCONNECTED_F;
+unsigned long sessionReachedMs = 0;     // 0 until the setpoint is first reached
+uint64_t sessionStartOnUs = 0;          // safetyHeaterOnUs() at the start...
+uint64_t sessionEndOnUs = 0;            // ... and at the end, once it's over
+uint64_t holdStartOnUs = 0;             // Both again on first reaching the setpoint
+int64_t holdStartUs = 0;                // esp_timer time of that, 0 until then
+EnergyMeter energyMeter;                // Today's and this month's on-time
+SessionEndReason sessionEndReason = SESSION_END_UNKNOWN;  // Set by whoever turns it off
+
+// Displays the connected network as a timed overlay; returns immediately
+void showIP() {
+  char ip[LCD_COLS + 1];
+  snprintf(ip, sizeof(ip), " %s", WiFi.localIP().toString().c_str());
+  displayOverlay(WiFi.SSID().c_str(), ip, IP_DISPLAY_TIME);
+}
 
-    if (httpResponseCode > 0) {
-      Serial.println("Message sent to Discord.");
+// Shows every probe as an overlay: first letter of its name and its reading
+void showProbes() {
+  char lines[2][LCD_COLS + 1] = { "", "" };
+  for (int i = 0; i < probeCount() && i < 4; i++) {
+    char cell[9];
+    const Probe& p = probe(i);
+    if (p.tempF == DEVICE_DISCONNECTED_F) {
+      snprintf(cell, sizeof(cell), "%c  --.- ", toupper(p.name[0]));
     } else {
-      Serial.printf("Failed to send message.  HTTP error: %d\n", httpResponseCode);
+      snprintf(cell, sizeof(cell), "%c%6.1f ", toupper(p.name[0]), p.tempF);
     }
-    
-    http.end();
+    strlcat(lines[i / 2], cell, sizeof(lines[i / 2]));
   }
+  if (probeCount() == 0) {
+    strlcpy(lines[0], "No probes", sizeof(lines[0]));
+  }
+  displayOverlay(lines[0], lines[1], IP_DISPLAY_TIME);
 }
 
-// Displays the connected network
-void showIP() {
-  lcd.clear();
-  lcd.setCursor(0,0);
-  lcd.print(WiFi.SSID());
-  lcd.setCursor(0,1);
-  lcd.print(" ");
-  lcd.print(WiFi.localIP());
-  delay(IP_DISPLAY_TIME);
-  lcd.clear();
-}
-
-// === Function to connect to WiFi ===
-void connectToWiFi(const char* ssid, const char* password) {
-  lcd.clear();
-  lcd.setCursor(0,0);
-  lcd.print("Try: ");
-  lcd.print(ssid);
-  Serial.printf("Connecting to %s...\n", ssid);
-  WiFi.begin(ssid, password);
-
-  unsigned long startAttemptTime = millis();
-
-  lcd.setCursor(0,1);
-  int progressCtr = 0;
-  // Keep trying to connect until timeout
-  while (WiFi.status() != WL_CONNECTED &&
-         millis() - startAttemptTime < wifiTimeout) {
-    delay(500);
-    progressCtr++;
-    Serial.print(".");
-    lcd.print(".");
-    if (progressCtr >= 6) {
-      //Clear progress
-      lcd.setCursor(0,1);
-      lcd.print("          ");
-      lcd.setCursor(0,1);
-      progressCtr = 0;
-    }
+// Gives the probes their roles from the settings (boot, and after /config)
+void applyProbeRoles() {
+  const char* const addresses[PROBE_ROLE_COUNT] = {
+    settings.probeBench, settings.probeCeiling, settings.probeHeater, settings.probeAux
+  };
+  probesAssignRoles(addresses);
+  if (probesHaveControl()) noBenchNotified = false;
+}
+
+// Applies and saves a setting edit from /config, then acts on the ones
+// read only at boot
+void applySetting(const SettingChange& change) {
+  const SettingDef& def = settingDef(change.index);
+  if (!settingSet(change.index, change.text)) {
+    Serial.printf("Setting %s not saved\n", def.key);
+    return;
+  }
+  if (strncmp(def.key, "probe", 5) == 0) applyProbeRoles();
+}
+
+// --- Turn the Sauna On/Off
+// The safety supervisor owns the pin and may refuse; returns what it did
+bool setSauna(bool on){
+  return safetySetHeater(on);
+}
+
+// Sessions need a probe in the bench role to regulate on.  Says why when
+// there isn't one (notifying once, not on every refused start), and
+// returns false so the caller doesn't start.
+bool canHeat() {
+  if (probesHaveControl()) return true;
+  displayOverlay("No bench probe", "Assign: Probes", IP_DISPLAY_TIME);
+  if (!noBenchNotified) {
+    sendNotification(NOTIFY_SENSOR_FAULT, "⚠️ No probe assigned to the bench role, not heating. Set one in the Probes menu or on /config.");
+    noBenchNotified = true;
+  }
+  return false;
+}
+
+// --- Autotune ---
+// Starts a relay autotune at the current setpoint, starting a full-length
+// session if the sauna is off
+bool startAutotune(unsigned long now) {
+  if (autotune.getState() == AUTOTUNE_RUNNING) return false;
+  if (!saunaOn && !canHeat()) return false;
+
+  if (!saunaOn) {
+    countdown.set(settings.maxTimeMin * 60000UL);
+    countdown.start(now);
+    saunaOn = true;
+  }
+  autotune.start(targetTempF, now);
+  sendNotification(NOTIFY_AUTOTUNE, "PID autotune started at " + String(targetTempF, 0) + " °F");
+  return true;
+}
+
+// Stops a running autotune, leaving the thermostat on its previous gains
+void cancelAutotune() {
+  if (autotune.getState() != AUTOTUNE_RUNNING) return;
+  autotune.cancel();
+  thermostat.reset(millis());
+  sendNotification(NOTIFY_AUTOTUNE, "PID autotune cancelled");
+}
+
+// Applies and persists the measured gains once the relay test is over
+void finishAutotune() {
+  thermostat.reset(millis());
+  if (autotune.getState() != AUTOTUNE_DONE) {
+    sendNotification(NOTIFY_AUTOTUNE, "PID autotune failed, keeping previous gains");
+    return;
+  }
+
+  PidGains gains = autotune.gains();
+  thermostat.setGains(gains);
+  saveGains(gains);
+
+  char msg[NOTIFY_MAX_MESSAGE];
+  snprintf(msg, sizeof(msg), "PID autotune done: Ku=%.3f Tu=%.0fs -> Kp=%.3f Ki=%.5f Kd=%.2f",
+           autotune.ultimateGain(), autotune.ultimatePeriodS(), gains.kp, gains.ki, gains.kd);
+  sendNotification(NOTIFY_AUTOTUNE, msg);
+}
+
+// True once SNTP has set the clock (time() counts from boot before that)
+bool clockValid() {
+  return time(nullptr) > 1600000000;
+}
+
+// --- Session log ---
+void beginSession(unsigned long now) {
+  sessionStartMs = now;
+  sessionPeakF = DEVICE_DISCONNECTED_F;
+  sessionReachedMs = 0;
+  sessionStartOnUs = safetyHeaterOnUs();
+  holdStartUs = 0;
+  sessionEndReason = SESSION_END_UNKNOWN;
+}
+
+// Folds a reading into the running session's peak and time-to-target
+void trackSession(float tempF, unsigned long now) {
+  if (!saunaOn || tempF == DEVICE_DISCONNECTED_F) return;
+  if (sessionPeakF == DEVICE_DISCONNECTED_F || tempF > sessionPeakF) sessionPeakF = tempF;
+  if (sessionReachedMs == 0 && tempF >= targetTempF) {
+    sessionReachedMs = now;
+    holdStartOnUs = safetyHeaterOnUs();
+    holdStartUs = esp_timer_get_time();
+  }
+}
+
+// SSR duty since the setpoint was first reached this session, -1 before
+// that.  Covers the whole hold, so it's what the thermostat costs to run.
+float holdDuty(uint64_t onUs) {
+  if (holdStartUs == 0) return -1;
+  int64_t heldUs = esp_timer_get_time() - holdStartUs;
+  return heldUs > 0 ? (float)(onUs - holdStartOnUs) / heldUs : 0;
+}
+
+// Day and month keys for the energy meter, from the local date
+void updateEnergy() {
+  int32_t dayKey = ENERGY_NO_KEY;
+  int32_t monthKey = ENERGY_NO_KEY;
+  if (clockValid()) {
+    time_t wall = time(nullptr);
+    struct tm t;
+    localtime_r(&wall, &t);
+    dayKey = (t.tm_year + 1900) * 1000 + t.tm_yday;
+    monthKey = (t.tm_year + 1900) * 100 + t.tm_mon + 1;
+  }
+  energyMeter.update(safetyHeaterOnUs(), dayKey, monthKey);
+}
+
+// Queues the finished session for the log; never waits on flash
+void endSession(unsigned long now) {
+  sessionEndOnUs = safetyHeaterOnUs();
+  uint64_t heaterUs = sessionEndOnUs - sessionStartOnUs;
+  float hold = holdDuty(sessionEndOnUs);
+
+  unsigned long durationMs = now - sessionStartMs;
+  SessionRecord record = {};
+  record.endReason = sessionEndReason;
+  record.startEpoch = clockValid() ? time(nullptr) - durationMs / 1000 : 0;
+  record.startUptimeS = sessionStartMs / 1000;
+  record.durationS = durationMs / 1000;
+  record.timeToTargetS = sessionReachedMs != 0 ? (sessionReachedMs - sessionStartMs) / 1000
+                                               : SESSION_NEVER_REACHED;
+  record.peakCentiF = sessionPeakF == DEVICE_DISCONNECTED_F ? SESSION_NO_PEAK : lroundf(sessionPeakF * 100);
+  record.setpointCentiF = lroundf(targetTempF * 100);
+  record.dutyPermille = durationMs > 0 ? heaterUs / durationMs : 0;   // µs / ms = permille
+  record.heaterOnS = heaterUs / 1000000;
+  record.energyWh = min(lroundf(energyKwh(heaterUs, settings.heaterWatts) * 1000), 65534L);
+  record.holdDutyPermille = hold < 0 ? SESSION_NEVER_HELD : lroundf(hold * 1000);
+  sessionLogAppend(record);
+
+  updateEnergy();
+  saveEnergy(energyMeter);
+}
+
+// --- Thermal model ---
+// Called on every 1 s history tick.  The mean over each step evens out the
+// coarse 9-bit readings used while heating.
+void feedThermalModel() {
+  if (currentTempF != DEVICE_DISCONNECTED_F) {
+    modelTempSum += currentTempF;
+    modelDutySum += heaterOn ? 1 : 0;
+    modelSamples++;
+  }
+  if (++modelTicks < THERMAL_STEP_S) return;
+
+  if (modelSamples > 0) {
+    thermalModel.update(modelTempSum / modelSamples, (float)modelDutySum / modelSamples);
+  }
+  modelTempSum = 0;
+  modelDutySum = 0;
+  modelSamples = 0;
+  modelTicks = 0;
+}
+
+// Seconds until the setpoint at full power, or -1 when off or not known.
+// Full power holds until the PID band, so this is slightly optimistic for
+// the last few degrees.
+long heatEtaSeconds() {
+  if (!saunaOn || currentTempF == DEVICE_DISCONNECTED_F) return -1;
+  return thermalModel.etaSeconds(currentTempF, targetTempF);
+}
+
+// --- Scheduled starts ---
+// How long before its start time an entry should switch on: long enough,
+// by the thermal model, for the room to be at temperature by then
+long preheatLeadS(int id) {
+  const ScheduleEntry& e = scheduler.entry(id);
+  if (!e.preheat) return 0;
+
+  float setpoint = e.setpointF != 0 ? e.setpointF : targetTempF;
+  long eta = currentTempF == DEVICE_DISCONNECTED_F
+                 ? -1 : thermalModel.etaSeconds(currentTempF, setpoint);
+  long minutes = eta >= 0 ? (eta + 59) / 60 + PREHEAT_MARGIN_MIN : PREHEAT_DEFAULT_MIN;
+  return min(minutes, PREHEAT_MAX_MIN) * 60;
+}
+
+// --- Schedule summary ---
+// Each entry's next start, for the snapshot.  Worked out again only when
+// the schedule changes or the clock reaches a new minute, not every pass.
+bool scheduleChanged = true;
+time_t scheduleSummaryMinute = -1;
+uint32_t scheduleNext[SCHEDULE_MAX_ENTRIES];
+uint32_t scheduleSoonest = 0;
+
+void updateScheduleSummary() {
+  bool synced = clockValid();
+  time_t now = time(nullptr);
+  time_t minute = synced ? now / 60 : 0;
+  if (!scheduleChanged && minute == scheduleSummaryMinute) return;
+  scheduleChanged = false;
+  scheduleSummaryMinute = minute;
+
+  for (int id = 0; id < Scheduler::SIZE; id++) {
+    scheduleNext[id] = synced && scheduler.entry(id).used ? scheduler.nextStart(id, now) : 0;
+  }
+  scheduleSoonest = synced ? scheduler.soonest(now) : 0;
+}
+
+// Starts the sauna when a scheduled entry comes due
+void serviceSchedule(unsigned long now) {
+  if (!clockValid()) return;
+
+  time_t wall = time(nullptr);
+  ScheduleEntry fired;
+  time_t start;
+  if (!scheduler.due(wall, preheatLeadS, fired, start)) return;
+  saveSchedule(scheduler);   // Fired weekly entries remember it; one-offs are gone
+  scheduleChanged = true;
+
+  if (saunaOn) {
+    sendNotification(NOTIFY_SCHEDULE, "Scheduled start skipped, sauna already on");
+    return;
+  }
+  if (!canHeat()) return;
+
+  if (fired.setpointF != 0) {
+    targetTempF = constrain((float)fired.setpointF, SETPOINT_MIN_F, SETPOINT_MAX_F);
+    thermostat.setSetpoint(targetTempF);
+    sessionMonitor.rearm();
   }
 
-  if (WiFi.status() == WL_CONNECTED) {
-    Serial.println("\nConnected!");
-    Serial.print("IP Address: ");
-    Serial.println(WiFi.localIP());
-    showIP();
+  // Preheat time comes out of the session cap, never on top of it
+  long preheatMin = start > wall ? (start - wall + 59) / 60 : 0;
+  long minutes = min(preheatMin + fired.durationMin, (long)settings.maxTimeMin);
+  countdown.set(minutes * 60000UL);
+  countdown.start(now);
+  saunaOn = true;
+
+  char msg[NOTIFY_MAX_MESSAGE];
+  if (preheatMin > 0) {
+    snprintf(msg, sizeof(msg), "Scheduled start: preheating %ld min to be at %.0f °F on time",
+             preheatMin, targetTempF);
   } else {
-    Serial.println("\nFailed to connect.");
-    WiFi.disconnect(true); // optional: ensure clean disconnect
-    delay(1000);
+    snprintf(msg, sizeof(msg), "Scheduled start: %ld min session", minutes);
   }
+  sendNotification(NOTIFY_SCHEDULE, msg);
 }
 
-// --- Turn the Sauna On/Off
-void setSauna(bool on){
-  if (on) {
-    digitalWrite(SSR_PIN, HIGH);
+// Overlay with the next scheduled start, e.g. "Next Sat 17:00" / "Preheat ~35m"
+void showSchedule() {
+  char line1[LCD_COLS + 1];
+  char line2[LCD_COLS + 1] = "";
+
+  int id = -1;
+  time_t next = clockValid() ? scheduler.soonest(time(nullptr), &id) : 0;
+  long lead = next != 0 ? preheatLeadS(id) : 0;
+
+  if (!clockValid()) {
+    strlcpy(line1, "Clock not set", sizeof(line1));
+  } else if (next == 0) {
+    strlcpy(line1, "No starts set", sizeof(line1));
+  } else {
+    struct tm t;
+    localtime_r(&next, &t);
+    strftime(line1, sizeof(line1), "Next %a %H:%M", &t);
+    if (lead > 0) snprintf(line2, sizeof(line2), "Preheat ~%ldm", lead / 60);
+  }
+  displayOverlay(line1, line2, IP_DISPLAY_TIME);
+}
+
+// Drives the SSR from the thermostat's time-proportioning output and wakes
+// loop() again at the next on/off edge
+void applyHeater(unsigned long now) {
+  bool want = saunaOn && thermostat.heaterOn(now);
+  // The safety supervisor may refuse to switch on, so go by what it did
+  bool actual = want != heaterOn ? setSauna(want) : heaterOn;
+  heaterOn = actual;   // safety.cpp times the SSR itself
+
+  if (saunaOn) {
+    armTimer(heaterTimer, thermostat.nextSwitchMs(now));
   } else {
-    digitalWrite(SSR_PIN, LOW);
+    xTimerStop(heaterTimer, 0);
   }
 }
 
 void updateStateAndDisplay() {
-  // Line 1: Temperature and Timer
-  lcd.setCursor(0, 0);
-  lcd.print(currentTempF, 1);
-  lcd.print((char)223); // Degree symbol
-  lcd.print("F");
-
-  if (!targetTempOneshotSent) {
-    if (currentTempF >= targetTempF) {
-      sendDiscordNotification("Sauna has reached target temp " + String(targetTempF) + " °F");
-      targetTempOneshotSent = true;
-    }
+  PerfTimer timer(displayProbe);
+  uint32_t events = sessionMonitor.update(saunaOn, currentTempF, targetTempF,
+                                          countdown.remainingMs(), settings.notifyLeftMin * 60000UL);
+  if (events & SESSION_EVENT_REACHED) {
+    sendNotification(NOTIFY_REACHED, "Sauna has reached target temp " + String(targetTempF) + " °F");
+  }
+  if (events & SESSION_EVENT_MINUTES_LEFT) {
+    sendNotification(NOTIFY_MINUTES_LEFT, "Sauna turns off in " +
+                     String((countdown.remainingMs() + 59999) / 60000) + " minutes");
   }
 
-  // Timer display
-  unsigned long secsLeft = countdownMillis / 1000;
-  int mins = secsLeft / 60;
-  int secs = secsLeft % 60;
-  
   // Update time remaining string
-  strTimeRemaining =  mins < 10 ? "0" : "";
-  strTimeRemaining += String(mins);
-  strTimeRemaining += ":";
-  strTimeRemaining += secs < 10 ? "0" : "";
-  strTimeRemaining += String(secs);
-
-  lcd.setCursor(8, 0);
-  lcd.print(strTimeRemaining);
+  char timeRemaining[TIME_STR_LEN];
+  countdown.format(timeRemaining, sizeof(timeRemaining));
+  strlcpy(strTimeRemaining, timeRemaining, sizeof(strTimeRemaining));
 
   // Update Sauna switch state, only if changed
-  if (saunaOn != lastSaunaState) {
-    setSauna(saunaOn);
-    sendDiscordNotification(saunaOn ? "Sauna turned ON 🔥" : "Sauna turned OFF 🚫");
-    lastSaunaState = saunaOn;
-    targetTempOneshotSent = saunaOn ? false : targetTempOneshotSent;
+  if (events & (SESSION_EVENT_ON | SESSION_EVENT_OFF)) {
+    safetySetSession(saunaOn);
+    if (saunaOn) {
+      thermostat.reset(millis());
+      beginSession(millis());
+    } else {
+      cancelAutotune();   // The relay test needs the heater
+      endSession(millis());
+    }
+    sendNotification(saunaOn ? NOTIFY_ON : NOTIFY_OFF,
+                     saunaOn ? "Sauna turned ON 🔥"
+                     : sessionEndReason == SESSION_END_OTA ? "Sauna turned OFF 🚫 for a firmware update"
+                                                           : "Sauna turned OFF 🚫");
   }
 
-  // Flame or underscore at (15, 0)
-  lcd.setCursor(15, 0);
-  if (saunaOn) {
-    lcd.write(byte(0)); // flame icon
+  // Hand the display task a snapshot; it renders on its own time
+  DisplayState screen;
+  screen.tempF = currentTempF;
+  strlcpy(screen.timeRemaining, timeRemaining, sizeof(screen.timeRemaining));
+  screen.saunaOn = saunaOn;
+  screen.isSettingTime = menu.isSettingTime();
+  screen.setMinutes = menu.minutes();
+  screen.menuLabel = menu.label();
+  long eta = heatEtaSeconds();
+  screen.etaMinutes = eta > 0 ? (eta + 59) / 60 : -1;
+  displayUpdate(screen);
+}
+
+// --- Encoder "Settings" menu ---
+// Rotate picks a setting, press edits it, rotate changes the value, press
+// saves it; a long press backs out one level.  Shown as an overlay.
+int menuSettingCount() {
+  int n = 0;
+  for (int i = 0; i < settingCount(); i++) {
+    if (settingDef(i).flags & SETTING_MENU) n++;
+  }
+  return n;
+}
+
+// Registry index of the nth encoder-editable setting
+int menuSetting(int nth) {
+  for (int i = 0; i < settingCount(); i++) {
+    if ((settingDef(i).flags & SETTING_MENU) && nth-- == 0) return i;
+  }
+  return -1;
+}
+
+void showSettingsMenu() {
+  const SettingDef& def = settingDef(menuSetting(settingsItem));
+  float value = editingSetting ? editValue : settingNumber(menuSetting(settingsItem));
+  char line2[LCD_COLS + 1];
+  snprintf(line2, sizeof(line2), "%c%g %s", editingSetting ? '>' : ' ', value, def.unit);
+  displayOverlay(def.label, line2, 0);
+}
+
+void handleSettingsInput(const InputEvent& input) {
+  int index = menuSetting(settingsItem);
+  const SettingDef& def = settingDef(index);
+
+  if (input.type == INPUT_ROTATE) {
+    if (editingSetting) {
+      editValue = constrain(editValue + input.delta * def.step, def.min, def.max);
+    } else {
+      int count = menuSettingCount();
+      settingsItem = ((settingsItem + input.delta) % count + count) % count;
+    }
+  } else if (input.type == INPUT_LONG_PRESS) {
+    if (editingSetting) {
+      editingSetting = false;         // Drop the edit
+    } else {
+      settingsItem = -1;              // Back to the main menu
+      displayClearOverlay();
+      return;
+    }
+  } else if (editingSetting) {
+    char text[16];
+    snprintf(text, sizeof(text), "%g", editValue);
+    settingSet(index, text);
+    editingSetting = false;
   } else {
-    lcd.print("_");
+    editValue = settingNumber(index);
+    editingSetting = true;
+  }
+  showSettingsMenu();
+}
+
+// One probe per screen: its address, then its role and reading
+void showProbesMenu() {
+  if (probeCount() == 0) {
+    displayOverlay("No probes", "", 0);
+    return;
+  }
+  static const char* names[] = PROBE_NAMES;
+  const Probe& p = probe(probeItem);
+  char id[17];
+  formatProbeAddress(p.address, id);
+  int role = editingRole ? editRole : p.role;
+  char line2[LCD_COLS + 1];
+  char temp[8] = "  --.-";
+  if (p.tempF != DEVICE_DISCONNECTED_F) snprintf(temp, sizeof(temp), "%6.1f", p.tempF);
+  snprintf(line2, sizeof(line2), "%d%c%-8.8s%s", probeItem + 1, editingRole ? '>' : ' ',
+           role == PROBE_UNASSIGNED ? "none" : names[role], temp);
+  displayOverlay(id, line2, 0);
+}
+
+// Saves the shown probe's address under its new role, taking it out of
+// any role it held before, then reassigns the probes
+void saveProbeRole() {
+  static const char* keys[PROBE_ROLE_COUNT] = { "probeBench", "probeCeil", "probeHeat", "probeAux" };
+  const char* const current[PROBE_ROLE_COUNT] = {
+    settings.probeBench, settings.probeCeiling, settings.probeHeater, settings.probeAux
+  };
+  char id[17];
+  formatProbeAddress(probe(probeItem).address, id);
+  for (int role = 0; role < PROBE_ROLE_COUNT; role++) {
+    if (role == editRole) {
+      settingSet(settingFind(keys[role]), id);
+    } else if (strcasecmp(current[role], id) == 0) {
+      settingSet(settingFind(keys[role]), "");
+    }
   }
+  applyProbeRoles();
+}
 
-  // Line 2: Menu or Time Setting
-  lcd.setCursor(0, 1);
-  if (isSettingTime) {
-    lcd.print(">Set Time: ");
-    if (setMinutes < 10) lcd.print(" ");
-    lcd.print(setMinutes);
-    lcd.print("m ");
+void handleProbesInput(const InputEvent& input) {
+  int count = probeCount();
+  if (input.type == INPUT_LONG_PRESS) {
+    if (editingRole) {
+      editingRole = false;            // Drop the edit
+    } else {
+      probeItem = -1;                 // Back to the main menu
+      displayClearOverlay();
+      return;
+    }
+  } else if (count == 0) {
+    // Nothing to pick; only a long press leaves
+  } else if (input.type == INPUT_ROTATE) {
+    if (editingRole) {
+      // Cycles unassigned, then each role
+      int span = PROBE_ROLE_COUNT + 1;
+      editRole = ((editRole + 1 + input.delta) % span + span) % span - 1;
+    } else {
+      probeItem = ((probeItem + input.delta) % count + count) % count;
+    }
+  } else if (editingRole) {
+    saveProbeRole();
+    editingRole = false;
   } else {
-    lcd.print(">");
-    lcd.print(menuItems[menuIndex]);
-    int len = strlen(menuItems[menuIndex]);
-    for (int i = 0; i < 15 - len; i++) lcd.print(" ");
+    editRole = probe(probeItem).role;
+    editingRole = true;
   }
+  showProbesMenu();
+}
+
+// --- Commands ---
+// The one place the session is changed on request, whoever asked: web
+// handlers and MQTT via the queue, the encoder menu directly
+void applyCommand(const Command& command, unsigned long now) {
+  switch (command.type) {
+    case CMD_ON:
+      if (countdown.remainingMs() == 0 && canHeat()) {
+        countdown.set(min(settings.onTimeMin, settings.maxTimeMin) * 60000UL);
+        countdown.start(now);
+        saunaOn = true;
+      }
+      break;
+
+    case CMD_START:
+      if (!saunaOn && countdown.remainingMs() > 0 && canHeat()) {
+        saunaOn = true;
+        countdown.start(now);
+      }
+      break;
+
+    case CMD_STOP:
+    case CMD_OFF:
+      if (saunaOn) {
+        sessionEndReason = command.source == SOURCE_MENU ? SESSION_END_MENU
+                         : command.source == SOURCE_MQTT ? SESSION_END_MQTT
+                         : command.source == SOURCE_OTA  ? SESSION_END_OTA
+                                                         : SESSION_END_WEB;
+      }
+      saunaOn = false;
+      if (command.type == CMD_OFF) countdown.set(0);
+      break;
+
+    case CMD_ADD_TIME: {
+      float minutes = command.value > 0 ? command.value : settings.addTimeMin;
+      countdown.add(minutes * 60000UL, settings.maxTimeMin * 60000UL, now);  // Never over the max time
+      int mins = countdown.remainingMs() / 60000;
+      sendNotification(NOTIFY_TIME_ADDED, "Time added to sauna timer: " + String(mins) + " minutes remaining.");
+      break;
+    }
+
+    case CMD_SETPOINT:
+      targetTempF = constrain(command.value, SETPOINT_MIN_F, SETPOINT_MAX_F);
+      thermostat.setSetpoint(targetTempF);
+      sessionMonitor.rearm();
+      break;
+
+    case CMD_AUTOTUNE:
+      startAutotune(now);
+      break;
+
+    case CMD_AUTOTUNE_CANCEL:
+      cancelAutotune();
+      break;
 
-  delay(2);  // Keep loop responsive
+    case CMD_SCHEDULE_ADD:
+      if (scheduler.add(command.entry) >= 0) {
+        saveSchedule(scheduler);
+        scheduleChanged = true;
+      }
+      break;
+
+    case CMD_SCHEDULE_REMOVE:
+      if (scheduler.remove((int)command.value)) {
+        saveSchedule(scheduler);
+        scheduleChanged = true;
+      }
+      break;
+  }
+}
+
+// Publishes what the rest of the firmware may read, once per loop() pass
+void publishState() {
+  ControllerSnapshot snap;
+  snap.tempF = currentTempF;
+  snap.setpointF = targetTempF;
+  snap.saunaOn = saunaOn;
+  snap.heaterOn = heaterOn;
+  snap.countdownMs = countdown.remainingMs();
+  strlcpy(snap.timeRemaining, strTimeRemaining, sizeof(snap.timeRemaining));
+  snap.etaS = heatEtaSeconds();
+  snap.duty = thermostat.output();
+  snap.mode = thermostat.getMode();
+  snap.gains = thermostat.getGains();
+  snap.autotune = autotune.getState();
+  snap.autotuneCycles = autotune.cyclesDone();
+  snap.sampleBits = probesResolution();
+  snap.samplePeriodMs = sampleProfile.periodMs;
+  snap.modelUpdates = thermalModel.updates();
+  snap.modelConverged = thermalModel.converged();
+  snap.modelTauS = thermalModel.timeConstantS();
+  snap.modelFullPowerF = thermalModel.steadyStateF(1.0f);
+  uint64_t onUs = safetyHeaterOnUs();
+  snap.sessionKwh = energyKwh((saunaOn ? onUs : sessionEndOnUs) - sessionStartOnUs, settings.heaterWatts);
+  // On-time held until the clock is set will land in today and this month
+  snap.todayKwh = energyKwh(energyMeter.dayOnUs() + energyMeter.heldOnUs(), settings.heaterWatts);
+  snap.monthKwh = energyKwh(energyMeter.monthOnUs() + energyMeter.heldOnUs(), settings.heaterWatts);
+  snap.holdDuty = saunaOn ? holdDuty(onUs) : -1;
+  snap.idle = idle;
+  updateScheduleSummary();
+  for (int id = 0; id < Scheduler::SIZE; id++) {
+    snap.schedule[id] = scheduler.entry(id);
+    snap.scheduleNext[id] = scheduleNext[id];
+  }
+  snap.nextStart = scheduleSoonest;
+  snap.probeCount = probeCount();
+  snap.haveControl = probesHaveControl();
+  for (int i = 0; i < snap.probeCount; i++) {
+    const Probe& p = probe(i);
+    memcpy(snap.probes[i].address, p.address, sizeof(DeviceAddress));
+    strlcpy(snap.probes[i].name, p.name, sizeof(snap.probes[i].name));
+    snap.probes[i].tempF = p.tempF;
+  }
+  for (int tier = 0; tier < HISTORY_TIERS; tier++) {
+    snap.history[tier].written = history.written(tier);
+    snap.history[tier].count = history.count(tier);
+    snap.history[tier].newestTimeS = history.newestTimeS(tier);
+  }
+  snap.heaterWatts = settings.heaterWatts;
+  snap.maxTimeMin = settings.maxTimeMin;
+  publishSnapshot(snap);
 }
 
 // =================================
 // ==  Web implementation         ==
 // =================================
-void handleRoot() {
-  String html = R"rawliteral(
-    <html>
-    <head>
-      <meta charset="UTF-8">
-      <meta name="viewport" content="width=device-width, initial-scale=1">
-      <!--<style>
-        body { font-family: sans-serif; text-align: center; padding: 20px; }
-        button { padding: 10px 20px; font-size: 18px; margin: 10px; }
-        .status { font-size: 24px; margin-top: 20px; }
-      </style>-->
-      <style>
-        body {
-          font-family: 'Segoe UI', sans-serif;
-          background: #f5f5f5;
-          color: #333;
-          padding: 20px;
-          text-align: center;
-        }
-        h1 {
-          color: #444;
-          margin-bottom: 10px;
-        }
-        .status {
-          background: white;
-          display: inline-block;
-          padding: 20px;
-          border-radius: 10px;
-          box-shadow: 0 4px 12px rgba(0,0,0,0.1);
-          margin-bottom: 20px;
-        }
-        .status p {
-          margin: 10px 0;
-          font-size: 1.2em;
-        }
-        button {
-          background: #007aff;
-          color: white;
-          border: none;
-          padding: 15px 25px;
-          font-size: 1.1em;
-          border-radius: 8px;
-          cursor: pointer;
-          margin: 10px;
-          box-shadow: 0 2px 6px rgba(0,0,0,0.1);
-          transition: background 0.3s;
-        }
-        button:hover {
-          background: #005fcc;
-        }
-        button:disabled {
-          background: #ccc;
-          cursor: now-allowed;
-          box-shadow: none;
-        }
-      </style>
-    </head>
-    <body>
-      <h1>Sauna Controller</h1>
-      <div class="status">
-        <p>Temperature: <span id="temp">--</span> °F</p>
-        <p>Time Remaining: <span id="time">--</span> min</p>
-        <p>Status: <span id="state">--</span></p>
-      </div>
-      <button id="onBtn" onclick="sendCommand('/on')">Turn ON</button>
-      <button id="offBtn" onclick="sendCommand('/off')">Turn OFF</button>
-      <!--<button id="addBtn" onclick="sendCommand('/addtime')">Add 15 min</button>-->
-      <button id="addBtn" onclick="addTimeCommand()">Add 15 min</button>
-
-      <script>
-        let remainingSeconds = 0;
-
-        function addTimeCommand() {
-          fetch('/addtime').then(() => setTimeout(() => {updateStatus();},500));
-        }
+// Sends one of the pages embedded by scripts/embed_web.py
+void sendGzipPage(AsyncWebServerRequest* request, const uint8_t* page, size_t len, const char* etag) {
+  // The browser revalidates every load; same firmware means same page
+  if (request->hasHeader("If-None-Match") &&
+      request->header("If-None-Match") == etag) {
+    request->send(304);
+    return;
+  }
 
-        function sendCommand(endpoint) {
-          fetch(endpoint).then(() => updateStatus());
-        }
+  // Streamed straight out of flash, already gzipped at build time
+  AsyncWebServerResponse* response = request->beginResponse_P(200, "text/html", page, len);
+  response->addHeader("Content-Encoding", "gzip");
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
+}
 
-        function updateStatus(){
-          fetch('/status')
-            .then(res => res.json())
-            .then(data => {
-              document.getElementById('temp').textContent = data.temp;
-
-              saunaOn = data.state === true || data.state === "On";
-              document.getElementById('state').textContent = saunaOn ? 'On' : 'Off';
-
-              // Enable/disable buttons
-              document.getElementById('onBtn').disabled = saunaOn;
-              document.getElementById('offBtn').disabled = !saunaOn;
-              document.getElementById('addBtn').disabled = !saunaOn;
-
-              if (saunaOn){
-                const [mm,ss] = data.time.split(':').map(Number);
-                remainingSeconds = mm * 60 + ss;
-              } else {
-                remainingSeconds = 0;
-              }
-
-              updateTimeDisplay();
-            });
-        }
+void handleRoot(AsyncWebServerRequest* request) {
+  sendGzipPage(request, INDEX_HTML_GZ, INDEX_HTML_GZ_LEN, INDEX_HTML_ETAG);
+}
 
-        function updateTimeDisplay() {
-          const mm = Math.floor(remainingSeconds / 60);
-          const ss = remainingSeconds % 60;
-          document.getElementById('time').textContent =
-            `${mm.toString().padStart(2,'0')}:${ss.toString().padStart(2,'0')}`;
-        }
+void handleConfigPage(AsyncWebServerRequest* request) {
+  sendGzipPage(request, CONFIG_HTML_GZ, CONFIG_HTML_GZ_LEN, CONFIG_HTML_ETAG);
+}
 
-        setInterval(() => {
-          if (saunaOn && remainingSeconds > 0) {
-            remainingSeconds--;
-            updateTimeDisplay();
-            if (remainingSeconds == 0){
-              // Pre-emptively set the state to 'Off' but use an asterisk to indicate "unofficial"
-              document.getElementById('state').textContent = 'Off*';
-            }
-          }
-        }, 1000);
-
-        setInterval(updateStatus, 5000);
-
-        updateStatus();
-      </script>
-    </body>
-    </html>
-  )rawliteral";
-  server.send(200, "text/html", html);
-}
-
-void handleOn() {
-  if (countdownMillis == 0) {
-    unsigned long now = millis();
-    lcd.setCursor(0,0);
-    countdownMillis = 90 * 60000UL;
-    targetTime = now + countdownMillis;
-    saunaOn = true;
-    server.send(200, "text/plain", "Sauna turned on");
+const char* settingTypeName(SettingType type) {
+  switch (type) {
+    case SETTING_INT: return "int";
+    case SETTING_FLOAT: return "float";
+    default: return "text";
   }
-  else {
-    server.send(200, "tesxt/plain", "Sauna already on");
+}
+
+// /config.json describes every setting for the /config page:
+//   {"settings":[{"key":"maxTime","label":"Max time","type":"int","unit":"min",
+//                 "min":10,"max":120,"value":90},...]}
+// Secrets come back with an empty value and "set" saying whether one is stored.
+void handleConfigJson(AsyncWebServerRequest* request) {
+  AsyncResponseStream* response = request->beginResponseStream("application/json");
+  response->print("{\"settings\":[");
+  for (int i = 0; i < settingCount(); i++) {
+    const SettingDef& def = settingDef(i);
+    char value[SETTING_PWD_LEN];
+    settingFormat(i, value, sizeof(value));
+    response->printf("%s{\"key\":\"%s\",\"label\":\"%s\",\"type\":\"%s\",\"unit\":\"%s\"",
+                     i > 0 ? "," : "", def.key, def.label, settingTypeName(def.type), def.unit);
+    if (def.type == SETTING_TEXT) {
+      // SSIDs are the only free text here; escape what would break the JSON
+      response->print(",\"value\":\"");
+      for (const char* p = value; *p; p++) {
+        if (*p == '"' || *p == '\\') response->print("\\");
+        response->write((uint8_t)*p);
+      }
+      response->print("\"");
+      if (def.flags & SETTING_SECRET) {
+        response->printf(",\"secret\":true,\"set\":%s", settingIsSet(i) ? "true" : "false");
+      }
+    } else {
+      response->printf(",\"min\":%g,\"max\":%g,\"value\":%s", def.min, def.max, value);
+    }
+    response->print("}");
   }
+  response->print("]}");
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
 }
 
-void handleOff() {
-  saunaOn = false;
-  countdownMillis = 0;
-  server.send(200, "text/plain", "Sauna turned off");
+// POST /config with form fields named by setting key saves each of them
+// (an empty secret clears it):
+//   {"saved":["maxTime"],"rejected":["addTime"]}
+// Each valid edit is queued for loop(), which applies and saves it; one the
+// full queue couldn't take is listed as rejected.
+void handleConfigSave(AsyncWebServerRequest* request) {
+  char saved[256] = "";
+  char rejected[256] = "";
+  for (int i = 0; i < settingCount(); i++) {
+    const SettingDef& def = settingDef(i);
+    if (!request->hasParam(def.key, true)) continue;
+
+    char* list = postSetting(i, request->getParam(def.key, true)->value().c_str()) ? saved : rejected;
+    size_t used = strlen(list);
+    snprintf(list + used, sizeof(saved) - used, "%s\"%s\"", used > 0 ? "," : "", def.key);
+  }
+
+  char reply[540];
+  snprintf(reply, sizeof(reply), "{\"saved\":[%s],\"rejected\":[%s]}", saved, rejected);
+  request->send(200, "application/json", reply);
 }
 
-void handleAddTime() {
-  unsigned long now = millis();                                       // Get the current time
-  unsigned long addMillis = 15 * 60000UL;                             // 15 minutes to add
-  countdownMillis = constrain((countdownMillis + addMillis), 0UL, (90 * 60000UL));  // Constrain to max of 90 minutes
-  targetTime = now + countdownMillis;                                 // Update target end time
-  server.send(200, "text/plain", "OK");                               // Respond to browser
-  unsigned long secsLeft = countdownMillis / 1000;
-  int mins = secsLeft / 60;
-  sendDiscordNotification("Time added to sauna timer: " + String(mins) + " minutes remaining.");
+// Replies for a command that couldn't be queued (loop() far behind)
+void sendBusy(AsyncWebServerRequest* request) {
+  request->send(503, "text/plain", "Busy, try again");
 }
 
-void handleStatus() {
-  String json = "{";
-  json += "\"temp\":" + String(currentTempF, 1) + ",";
-  json += "\"time\":\"" + strTimeRemaining + "\",";
-  json += "\"state\":";
-  json += (saunaOn ? "true" : "false");
-  json += "}";
-  server.send(200, "application/json", json);
+void handleOn(AsyncWebServerRequest* request) {
+  ControllerSnapshot snap;
+  readSnapshot(snap);
+  if (!snap.haveControl) {
+    request->send(409, "text/plain", "No bench probe assigned, not heating");
+    return;
+  }
+  if (!postCommand(CMD_ON, SOURCE_WEB)) return sendBusy(request);
+  request->send(200, "text/plain", snap.countdownMs == 0 ? "Sauna turned on" : "Sauna already on");
 }
 
-void setup() {
-  // --- Initialize sensors, lcd, and encoder
-  Serial.begin(9600);
-  delay(1000); // give time for Serial
+void handleOff(AsyncWebServerRequest* request) {
+  if (!postCommand(CMD_OFF, SOURCE_WEB)) return sendBusy(request);
+  request->send(200, "text/plain", "Sauna turned off");
+}
 
-  pinMode(SSR_PIN, OUTPUT);
-  pinMode(ENCODER_SW, INPUT_PULLUP);
+void handleAddTime(AsyncWebServerRequest* request) {
+  if (!postCommand(CMD_ADD_TIME, SOURCE_WEB)) return sendBusy(request);   // 0 = the setting
+  request->send(200, "text/plain", "OK");                             // Respond to browser
+}
 
-  // Set up encoder
-  encoder.attachFullQuad(ENCODER_A, ENCODER_B);
-  encoder.clearCount();
+const char* autotuneStateName(AutotuneState state) {
+  switch (state) {
+    case AUTOTUNE_RUNNING: return "running";
+    case AUTOTUNE_DONE: return "done";
+    case AUTOTUNE_FAILED: return "failed";
+    default: return "idle";
+  }
+}
 
-  // Set up lcd
-  lcd.init();
-  lcd.backlight();
-  lcd.createChar(0, flameChar);
+// snprintf that appends at buf + n, and does nothing once buf is full
+int appendf(char* buf, size_t len, int n, const char* fmt, ...) {
+  if (n < 0 || n >= (int)len) return n;
+  va_list args;
+  va_start(args, fmt);
+  n += vsnprintf(buf + n, len - n, fmt, args);
+  va_end(args);
+  return n;
+}
 
-  sensors.begin();
-  if (sensors.getAddress(sensorAddress, 0)){
-    sensors.setResolution(sensorAddress, 10);
-  }
+// Replies 500 for JSON that didn't fit its buffer, rather than sending it cut off
+void sendJsonOverflow(AsyncWebServerRequest* request, const char* what) {
+  Serial.printf("%s JSON did not fit its buffer\n", what);
+  request->send(500, "application/json", "{\"error\":\"response too large\"}");
+}
 
-  // --- Connect to primary or secondary WiFi
-  connectToWiFi(WIFI_SSID_1, WIFI_PWD_1);
+// Writes the status JSON into buf without touching the heap.  /events gets
+// the live fields only (LIVE_JSON_LEN is plenty); /status adds the
+// diagnostics.  Returns the length, or -1 if it didn't all fit, in which
+// case buf holds no valid JSON and mustn't be sent.
+int writeStatusJson(char* buf, size_t len, bool withDiagnostics) {
+  ControllerSnapshot snap;
+  readSnapshot(snap);
+
+  int n = appendf(buf, len, 0,
+                  "{\"temp\":%.1f,\"time\":\"%s\",\"state\":%s,\"setpoint\":%.1f,\"heater\":%s",
+                  snap.tempF, snap.timeRemaining, snap.saunaOn ? "true" : "false", snap.setpointF,
+                  snap.heaterOn ? "true" : "false");
+  if (snap.etaS >= 0) {
+    n = appendf(buf, len, n, ",\"eta\":%ld", snap.etaS);
+  } else {
+    n = appendf(buf, len, n, ",\"eta\":null");
+  }
 
-  if (WiFi.status() != WL_CONNECTED) {
-    connectToWiFi(WIFI_SSID_2, WIFI_PWD_2);
+  if (withDiagnostics) {
+    n = appendf(buf, len, n, ",\"duty\":%.2f,\"mode\":\"%s\",\"idle\":%s", snap.duty,
+                snap.mode == THERMOSTAT_PID ? "pid" : "hysteresis", snap.idle ? "true" : "false");
+    n = appendf(buf, len, n, ",\"sampling\":{\"bits\":%u,\"periodMs\":%lu}",
+                snap.sampleBits, snap.samplePeriodMs);
+    n = appendf(buf, len, n, ",\"probes\":[");
+    for (int i = 0; i < snap.probeCount; i++) {
+      const ProbeReading& p = snap.probes[i];
+      char id[17];
+      formatProbeAddress(p.address, id);
+      n = appendf(buf, len, n, "%s{\"name\":\"%s\",\"id\":\"%s\",\"temp\":%.1f}",
+                  i > 0 ? "," : "", p.name, id, p.tempF);
+    }
+    n = appendf(buf, len, n, "]");
+    n = appendf(buf, len, n, ",\"gains\":{\"kp\":%.4f,\"ki\":%.6f,\"kd\":%.3f}",
+                snap.gains.kp, snap.gains.ki, snap.gains.kd);
+    n = appendf(buf, len, n, ",\"autotune\":{\"state\":\"%s\",\"cycles\":%d}",
+                autotuneStateName(snap.autotune), snap.autotuneCycles);
+    n = appendf(buf, len, n, ",\"model\":{\"updates\":%lu,\"converged\":%s",
+                (unsigned long)snap.modelUpdates, snap.modelConverged ? "true" : "false");
+    if (snap.modelConverged) {
+      n = appendf(buf, len, n, ",\"tauS\":%.0f,\"fullPowerF\":%.1f",
+                  snap.modelTauS, snap.modelFullPowerF);
+    }
+    n = appendf(buf, len, n, "}");
+    if (clockValid()) {
+      n = appendf(buf, len, n, ",\"clock\":%lu", (unsigned long)time(nullptr));
+    } else {
+      n = appendf(buf, len, n, ",\"clock\":null");
+    }
+    if (snap.nextStart != 0) {
+      n = appendf(buf, len, n, ",\"nextStart\":%lu", (unsigned long)snap.nextStart);
+    } else {
+      n = appendf(buf, len, n, ",\"nextStart\":null");
+    }
+    WifiStats wifi = wifiGetStats();
+    n = appendf(buf, len, n, ",\"wifi\":{\"state\":\"%s\",\"rssi\":%d,\"connects\":%lu,"
+                "\"fastConnects\":%lu,\"drops\":%lu,\"lastConnectMs\":%lu}",
+                wifiStateName(wifi.state), wifi.state == WIFI_CONNECTED ? WiFi.RSSI() : 0,
+                wifi.connects, wifi.fastConnects, wifi.drops, wifi.lastConnectMs);
+    MqttStats mqtt = mqttGetStats();
+    if (mqtt.enabled) {
+      n = appendf(buf, len, n, ",\"mqtt\":{\"connected\":%s,\"connects\":%lu,\"publishes\":%lu,\"commands\":%lu}",
+                  mqtt.connected ? "true" : "false", mqtt.connects, mqtt.publishes, mqtt.commands);
+    }
+    OtaStats ota = otaGetStats();
+    n = appendf(buf, len, n, ",\"ota\":{\"enabled\":%s,\"inProgress\":%s,\"partition\":\"%s\",\"lastError\":\"%s\"}",
+                ota.enabled ? "true" : "false", ota.inProgress ? "true" : "false",
+                ota.partition, ota.lastError);
+    n = appendf(buf, len, n, ",\"safety\":{\"trip\":\"%s\",\"trips\":%lu}",
+                safetyTripName(safetyTripped()), safetyTripCount());
+    n = appendf(buf, len, n, ",\"energy\":{\"watts\":%ld,\"sessionKwh\":%.3f,\"todayKwh\":%.3f,"
+                "\"monthKwh\":%.3f,\"holdDuty\":", (long)snap.heaterWatts,
+                snap.sessionKwh, snap.todayKwh, snap.monthKwh);
+    if (snap.holdDuty >= 0) {
+      n = appendf(buf, len, n, "%.3f}", snap.holdDuty);
+    } else {
+      n = appendf(buf, len, n, "null}");
+    }
+    n = appendf(buf, len, n, ",\"heap\":{\"free\":%u,\"minFree\":%u,\"largestBlock\":%u}",
+                (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getMinFreeHeap(),
+                (unsigned)ESP.getMaxAllocHeap());
+    // One block per configured sink, named after it ("discord", "mqtt", "ntfy")
+    n = appendf(buf, len, n, ",\"notify\":{\"dropped\":%lu,\"coalesced\":%lu",
+                notifierDroppedCount(), notifierCoalescedCount());
+    for (int i = 0; i < NOTIFY_SINK_COUNT; i++) {
+      NotifierStats sink = notifierGetStats((NotifySinkId)i);
+      if (!sink.enabled) continue;
+      n = appendf(buf, len, n, ",\"%s\":{\"handshakes\":%lu,\"sent\":%lu,\"avgMs\":%lu,"
+                  "\"dropped\":%lu,\"rateLimited\":%lu}",
+                  notifySinkName((NotifySinkId)i), sink.handshakes, sink.sent, sink.avgSendMs,
+                  sink.dropped, sink.rateLimited);
+    }
+    n = appendf(buf, len, n, "}");
   }
 
-  if (WiFi.status() != WL_CONNECTED) {
-    Serial.println("Could not connect to any network.");
+  n = appendf(buf, len, n, "}");
+  return n >= 0 && n < (int)len ? n : -1;
+}
+
+// /setpoint?f=<degrees F> changes the thermostat target
+void handleSetpoint(AsyncWebServerRequest* request) {
+  if (!request->hasParam("f")) {
+    request->send(400, "text/plain", "Missing f");
+    return;
   }
 
-  // -- Register website paths
-  server.on("/", handleRoot);
-  server.on("/on", handleOn);
-  server.on("/off", handleOff);
-  server.on("/addtime", handleAddTime);
-  server.on("/status", handleStatus);
-  server.begin();
+  float setpoint = constrain(request->getParam("f")->value().toFloat(), SETPOINT_MIN_F, SETPOINT_MAX_F);
+  if (!postCommand(CMD_SETPOINT, SOURCE_WEB, setpoint)) return sendBusy(request);
 
-  lcd.clear();
-  updateStateAndDisplay();
+  char reply[32];
+  snprintf(reply, sizeof(reply), "Setpoint %.1f F", setpoint);
+  request->send(200, "text/plain", reply);
 }
 
-void loop() {
-  server.handleClient();
+// /autotune starts a relay autotune, /autotune?cancel=1 stops it
+void handleAutotune(AsyncWebServerRequest* request) {
+  bool cancel = request->hasParam("cancel");
+  ControllerSnapshot snap;
+  readSnapshot(snap);
+  bool started = !cancel && snap.autotune != AUTOTUNE_RUNNING;
+  if (started && !snap.saunaOn && !snap.haveControl) {
+    request->send(409, "text/plain", "No bench probe assigned, not heating");
+    return;
+  }
+  if (!postCommand(cancel ? CMD_AUTOTUNE_CANCEL : CMD_AUTOTUNE, SOURCE_WEB)) return sendBusy(request);
 
-  unsigned long now = millis();
+  if (cancel) {
+    request->send(200, "text/plain", "Autotune cancelled");
+  } else {
+    request->send(200, "text/plain", started ? "Autotune started" : "Autotune already running");
+  }
+}
 
-  // --- Non-blocking Temperature read every 1s ---
-  if (!tempConversionInProgress && (now - lastTempRead >= 1000)){
-    sensors.requestTemperatures();
-    tempRequestTime = now;
-    tempConversionInProgress = true;
+// /history?tier=0|1|2 streams one history tier, oldest first:
+//   {"tier":1,"interval":10,"now":<uptime s>,"end":<uptime s of last>,"temps":[72.5,null,...]}
+// The response is chunked straight out of the ring, never built in RAM;
+// where the tier stands comes from the snapshot.
+void handleHistory(AsyncWebServerRequest* request) {
+  int tier = request->hasParam("tier") ? request->getParam("tier")->value().toInt() : 0;
+  if (tier < 0 || tier >= HISTORY_TIERS) {
+    request->send(400, "text/plain", "Bad tier");
+    return;
   }
 
-  if (tempConversionInProgress && (now - tempRequestTime >= 750)) {
-    if (sensors.isConversionComplete()){
-      currentTempF = sensors.getTempFByIndex(0);
-      lastTempRead = now;
-      tempConversionInProgress = false;
+  ControllerSnapshot snap;
+  readSnapshot(snap);
+  uint32_t end = snap.history[tier].written;
+  uint32_t first = end - snap.history[tier].count;
+  uint32_t seq = first;
+  uint32_t endTimeS = snap.history[tier].newestTimeS;
+  uint32_t nowS = millis() / 1000;
+
+  // Text that didn't fit the last chunk waits here for the next one: the
+  // header to start with, then one entry at a time, then the closing "]}".
+  // Returning 0 ends the response, so a chunk is never left empty early.
+  char staged[96];
+  int headerLen = snprintf(staged, sizeof(staged), "{\"tier\":%d,\"interval\":%u,\"now\":%lu,\"end\":%lu,\"temps\":[",
+                           tier, HISTORY_INTERVAL_S[tier], (unsigned long)nowS, (unsigned long)endTimeS);
+  size_t stagedLen = min((size_t)headerLen, sizeof(staged) - 1);
+  size_t stagedPos = 0;
+  bool closed = false;
+
+  AsyncWebServerResponse* response = request->beginChunkedResponse("application/json",
+      [=](uint8_t* buffer, size_t maxLen, size_t index) mutable -> size_t {
+    size_t n = 0;
+    while (n < maxLen) {
+      if (stagedPos < stagedLen) {
+        size_t take = min(stagedLen - stagedPos, maxLen - n);
+        memcpy(buffer + n, staged + stagedPos, take);
+        stagedPos += take;
+        n += take;
+        continue;
+      }
+      stagedPos = 0;
+      if (seq < end) {
+        // A sample lapped by the writer reads as null
+        int16_t centiF;
+        const char* comma = seq > first ? "," : "";
+        if (history.read(tier, seq, centiF) && centiF != HISTORY_NO_SAMPLE) {
+          stagedLen = snprintf(staged, sizeof(staged), "%s%.1f", comma, centiF / 100.0f);
+        } else {
+          stagedLen = snprintf(staged, sizeof(staged), "%snull", comma);
+        }
+        seq++;
+      } else if (!closed) {
+        stagedLen = snprintf(staged, sizeof(staged), "]}");
+        closed = true;
+      } else {
+        stagedLen = 0;
+        break;
+      }
     }
+    return n;   // 0 once everything is out, which ends the response
+  });
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
+// /history.bin?tier=0|1|2[&since=<uptime s>] streams a tier in the compact
+// binary format, oldest first.  Little-endian 16-byte header:
+//   "SH", version (1), tier, interval s (u16), sample count (u16),
+//   now (u32 uptime s), end (u32 uptime s of the last sample)
+// followed by one DeltaEncoder varint per sample.  With since, only
+// samples newer than that are sent, so a client can poll incrementally.
+void handleHistoryBinary(AsyncWebServerRequest* request) {
+  int tier = request->hasParam("tier") ? request->getParam("tier")->value().toInt() : 0;
+  if (tier < 0 || tier >= HISTORY_TIERS) {
+    request->send(400, "text/plain", "Bad tier");
+    return;
   }
 
-  // --- Encoder Movement ---
-  long newPosition = encoder.getCount() / 4;  // divide by 4 to account for encoder resolution
+  ControllerSnapshot snap;
+  readSnapshot(snap);
+  uint32_t end = snap.history[tier].written;
+  uint32_t first = end - snap.history[tier].count;
+  uint32_t endTimeS = snap.history[tier].newestTimeS;
+  uint32_t nowS = millis() / 1000;
+  uint16_t interval = HISTORY_INTERVAL_S[tier];
+
+  if (request->hasParam("since") && end > first) {
+    // Sample seq was taken at endTimeS - (end - 1 - seq) * interval
+    uint32_t since = request->getParam("since")->value().toInt();
+    uint32_t newer = since >= endTimeS ? 0 : (endTimeS - since + interval - 1) / interval;
+    if (newer < end - first) first = end - newer;
+  }
+
+  uint8_t header[16] = { 'S', 'H', 1, (uint8_t)tier };
+  uint16_t count = end - first;
+  memcpy(header + 4, &interval, 2);
+  memcpy(header + 6, &count, 2);
+  memcpy(header + 8, &nowS, 4);
+  memcpy(header + 12, &endTimeS, 4);
+
+  uint32_t seq = first;
+  DeltaEncoder encoder;
+
+  // Bytes that didn't fit the last chunk wait here for the next one: the
+  // header to start with, then at most one encoded sample.  Returning 0
+  // ends the response, so a chunk is never left empty while data remains.
+  uint8_t staged[sizeof(header)];
+  memcpy(staged, header, sizeof(header));
+  size_t stagedLen = sizeof(header);
+  size_t stagedPos = 0;
+
+  AsyncWebServerResponse* response = request->beginChunkedResponse("application/octet-stream",
+      [=](uint8_t* buffer, size_t maxLen, size_t index) mutable -> size_t {
+    size_t n = 0;
+    while (n < maxLen) {
+      if (stagedPos < stagedLen) {
+        size_t take = min(stagedLen - stagedPos, maxLen - n);
+        memcpy(buffer + n, staged + stagedPos, take);
+        stagedPos += take;
+        n += take;
+        continue;
+      }
+      if (seq >= end) break;
+
+      int16_t centiF;
+      if (!history.read(tier, seq, centiF)) centiF = HISTORY_NO_SAMPLE;
+      seq++;
+      if (n + DELTA_MAX_BYTES <= maxLen) {
+        n += encoder.encode(centiF, buffer + n);   // Room for any sample: straight in
+      } else {
+        stagedLen = encoder.encode(centiF, staged);
+        stagedPos = 0;
+      }
+    }
+    return n;   // 0 once everything is out, which ends the response
+  });
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
+const char* sessionEndName(uint8_t reason) {
+  switch (reason) {
+    case SESSION_END_TIMER: return "timer";
+    case SESSION_END_MENU: return "menu";
+    case SESSION_END_WEB: return "web";
+    case SESSION_END_FAULT: return "fault";
+    case SESSION_END_MQTT: return "mqtt";
+    case SESSION_END_OTA: return "ota";
+    default: return "unknown";
+  }
+}
 
-  if (newPosition != lastPosition) {
-    int delta = newPosition - lastPosition;
+// /sessions?page=N[&per=M] pages through the session log, newest first
+// (page 0 is the latest per sessions):
+//   {"total":12,"page":0,"per":20,"sessions":[{"start":<epoch or 0>,...},...]}
+// Only the requested page is read; the file is never loaded whole.
+struct SessionPage {
+  SessionRecord records[SESSION_PAGE_MAX];
+  int count;
+};
 
-    if (isSettingTime) {
-      setMinutes += (delta > 0 ? 1 : -1);
-      // Implemnent roll around
-      if (setMinutes > MAX_TIME) {
-        Serial.println("positive");
-        setMinutes = 0;
+void handleSessions(AsyncWebServerRequest* request) {
+  uint32_t page = request->hasParam("page") ? request->getParam("page")->value().toInt() : 0;
+  uint32_t per = request->hasParam("per") ? request->getParam("per")->value().toInt() : 20;
+  per = constrain(per, 1U, (uint32_t)SESSION_PAGE_MAX);
+  page = min(page, (uint32_t)(UINT32_MAX / per));   // So page * per can't wrap
+
+  // The whole page comes from the log task in one round trip, here, so the
+  // chunk callback only formats; it lives on the heap until the response goes
+  std::shared_ptr<SessionPage> sessions(new (std::nothrow) SessionPage);
+  if (!sessions) return sendBusy(request);
+  uint32_t total = 0;
+  sessions->count = sessionLogReadPage(page * per, per, sessions->records, total);
+  if (sessions->count < 0) return sendBusy(request);
+  int next = 0;
+
+  // Text that didn't fit the last chunk waits here for the next one: the
+  // header to start with, then one session at a time, then the closing
+  // "]}".  Returning 0 ends the response, so a chunk is never left empty early.
+  char staged[288];
+  int headerLen = snprintf(staged, sizeof(staged), "{\"total\":%lu,\"page\":%lu,\"per\":%lu,\"sessions\":[",
+                           (unsigned long)total, (unsigned long)page, (unsigned long)per);
+  size_t stagedLen = min((size_t)headerLen, sizeof(staged) - 1);
+  size_t stagedPos = 0;
+  bool closed = false;
+
+  AsyncWebServerResponse* response = request->beginChunkedResponse("application/json",
+      [=](uint8_t* buffer, size_t maxLen, size_t index) mutable -> size_t {
+    size_t n = 0;
+    while (n < maxLen) {
+      if (stagedPos < stagedLen) {
+        size_t take = min(stagedLen - stagedPos, maxLen - n);
+        memcpy(buffer + n, staged + stagedPos, take);
+        stagedPos += take;
+        n += take;
+        continue;
       }
-      //Serial.print(MAX_TIME);
-      //Serial.println(" max");
-      //Serial.println(setMinutes);
-      if (setMinutes < 0) {
-        Serial.println("negative");
-        setMinutes = MAX_TIME;
+      stagedPos = 0;
+      if (closed) {
+        stagedLen = 0;
+        break;
       }
+      if (next >= sessions->count) {
+        stagedLen = snprintf(staged, sizeof(staged), "]}");
+        closed = true;
+        continue;
+      }
+
+      const SessionRecord& r = sessions->records[next];
+      char peak[12] = "null";
+      if (r.peakCentiF != SESSION_NO_PEAK) snprintf(peak, sizeof(peak), "%.2f", r.peakCentiF / 100.0f);
+
+      // Version 1 records predate the energy fields
+      char energy[48] = "\"kWh\":null,\"holdDuty\":null";
+      if (r.version >= 2) {
+        int at = snprintf(energy, sizeof(energy), "\"kWh\":%.3f,\"holdDuty\":", r.energyWh / 1000.0f);
+        if (r.holdDutyPermille != SESSION_NEVER_HELD) {
+          snprintf(energy + at, sizeof(energy) - at, "%.3f", r.holdDutyPermille / 1000.0f);
+        } else {
+          snprintf(energy + at, sizeof(energy) - at, "null");
+        }
+      }
+
+      int len = snprintf(staged, sizeof(staged),
+          "%s{\"start\":%lu,\"uptime\":%lu,\"duration\":%lu,\"toTarget\":%ld,"
+          "\"peak\":%s,\"setpoint\":%.2f,\"duty\":%.3f,\"heaterOn\":%lu,%s,\"end\":\"%s\"}",
+          next > 0 ? "," : "", (unsigned long)r.startEpoch, (unsigned long)r.startUptimeS,
+          (unsigned long)r.durationS,
+          r.timeToTargetS == SESSION_NEVER_REACHED ? -1L : (long)r.timeToTargetS,
+          peak, r.setpointCentiF / 100.0f, r.dutyPermille / 1000.0f,
+          (unsigned long)r.heaterOnS, energy, sessionEndName(r.endReason));
+      stagedLen = min((size_t)len, sizeof(staged) - 1);
+      next++;
+    }
+    return n;   // 0 once everything is out, which ends the response
+  });
+  response->addHeader("Cache-Control", "no-store");
+  request->send(response);
+}
+
+// /schedule lists the scheduled starts:
+//   {"clock":<epoch or null>,"entries":[{"id":0,"days":"Sat","at":"17:00",
+//    "minutes":60,"preheat":true,"setpoint":0,"next":<epoch or null>},...]}
+// One-off entries have "days":"" and "at" as local "YYYY-MM-DD HH:MM".
+// Read from the snapshot; the schedule itself is loop()'s.
+void handleSchedule(AsyncWebServerRequest* request) {
+  ControllerSnapshot snap;
+  readSnapshot(snap);
+  char json[SCHEDULE_JSON_LEN];
+  bool synced = clockValid();
+  time_t now = time(nullptr);
+
+  int n = synced ? appendf(json, sizeof(json), 0, "{\"clock\":%lu,\"entries\":[", (unsigned long)now)
+                 : appendf(json, sizeof(json), 0, "{\"clock\":null,\"entries\":[");
+  bool first = true;
+  for (int id = 0; id < Scheduler::SIZE; id++) {
+    const ScheduleEntry& e = snap.schedule[id];
+    if (!e.used) continue;
+
+    char days[32];
+    char at[20];
+    formatWeekdays(e.weekdays, days, sizeof(days));
+    if (e.weekdays != 0) {
+      snprintf(at, sizeof(at), "%02u:%02u", e.minuteOfDay / 60, e.minuteOfDay % 60);
     } else {
-      menuIndex += (delta > 0 ? 1 : -1);
-      if (menuIndex < 0) menuIndex = menuLength - 1;
-      if (menuIndex >= menuLength) menuIndex = 0;
+      time_t once = e.onceEpoch;
+      struct tm t;
+      localtime_r(&once, &t);
+      strftime(at, sizeof(at), "%Y-%m-%d %H:%M", &t);
     }
+    uint32_t next = synced ? snap.scheduleNext[id] : 0;
+
+    n = appendf(json, sizeof(json), n,
+                "%s{\"id\":%d,\"days\":\"%s\",\"at\":\"%s\",\"minutes\":%u,\"preheat\":%s,\"setpoint\":%d,",
+                first ? "" : ",", id, days, at, e.durationMin, e.preheat ? "true" : "false", e.setpointF);
+    n = next != 0 ? appendf(json, sizeof(json), n, "\"next\":%lu}", (unsigned long)next)
+                  : appendf(json, sizeof(json), n, "\"next\":null}");
+    first = false;
+  }
+  n = appendf(json, sizeof(json), n, "]}");
+  if (n < 0 || n >= (int)sizeof(json)) return sendJsonOverflow(request, "/schedule");
+  request->send(200, "application/json", json);
+}
 
-    lastPosition = newPosition;
+// /schedule/add adds a start.  One of:
+//   at=HH:MM&days=sat,sun   weekly (days also takes daily/weekdays/weekends)
+//   at=HH:MM                once, next time the clock reads that
+//   at=YYYY-MM-DDTHH:MM     once, on that date
+//   in=<minutes>            once, that far from now
+// plus optional minutes=<session length, default 60>, preheat=1 to be at
+// temperature by the start time, and f=<setpoint F>.  loop() stores it;
+// "full" is judged from the snapshot.
+void handleScheduleAdd(AsyncWebServerRequest* request) {
+  ControllerSnapshot snap;
+  readSnapshot(snap);
+  ScheduleEntry entry = {};
+  entry.durationMin = request->hasParam("minutes")
+                          ? constrain(request->getParam("minutes")->value().toInt(), 1L, (long)snap.maxTimeMin)
+                          : 60;
+  entry.preheat = request->hasParam("preheat") && request->getParam("preheat")->value() != "0";
+  if (request->hasParam("f")) {
+    entry.setpointF = constrain(request->getParam("f")->value().toFloat(), SETPOINT_MIN_F, SETPOINT_MAX_F);
   }
 
-  // --- Button Press Detection ---
-  bool currentButtonState = digitalRead(ENCODER_SW);
-  if (lastButtonState == HIGH && currentButtonState == LOW) {
+  bool weekly = request->hasParam("days");
+  if (!weekly && !clockValid()) {
+    request->send(503, "text/plain", "Clock not set yet");
+    return;
+  }
 
-    // -- Handle button press --
-    if (isSettingTime) {
-      countdownMillis = setMinutes * 60000UL;
-      isSettingTime = false;
+  time_t now = time(nullptr);
+  String at = request->hasParam("at") ? request->getParam("at")->value() : "";
+  int year, month, day, hour, minute;
+  if (request->hasParam("in")) {
+    entry.onceEpoch = now + request->getParam("in")->value().toInt() * 60L;
+  } else if (sscanf(at.c_str(), "%d-%d-%dT%d:%d", &year, &month, &day, &hour, &minute) == 5) {
+    struct tm t = {};
+    t.tm_year = year - 1900;
+    t.tm_mon = month - 1;
+    t.tm_mday = day;
+    t.tm_hour = hour;
+    t.tm_min = minute;
+    t.tm_isdst = -1;
+    entry.onceEpoch = mktime(&t);
+  } else if (sscanf(at.c_str(), "%d:%d", &hour, &minute) == 2 && hour < 24 && minute < 60) {
+    if (weekly) {
+      entry.weekdays = parseWeekdays(request->getParam("days")->value().c_str());
+      entry.minuteOfDay = hour * 60 + minute;
     } else {
-      String selected = menuItems[menuIndex];
-      if (selected == "Start" && !saunaOn && countdownMillis > 0) {
-        saunaOn = true;
-        targetTime = now + countdownMillis;
-      } else if (selected == "Stop" && saunaOn) {
-        saunaOn = false;
-      } else if (selected == "Set" && !saunaOn) {
-        isSettingTime = true;
-      } else if (selected == "IP") {
-        showIP();
+      struct tm t;
+      localtime_r(&now, &t);
+      t.tm_hour = hour;
+      t.tm_min = minute;
+      t.tm_sec = 0;
+      t.tm_isdst = -1;
+      time_t once = mktime(&t);
+      if (once <= now) {
+        t.tm_mday++;
+        t.tm_isdst = -1;
+        once = mktime(&t);
       }
+      entry.onceEpoch = once;
     }
   }
 
-  lastButtonState = currentButtonState;
-   
-  // --- Countdown logic ---
-  if (saunaOn && countdownMillis > 0) {
-    long remaining = targetTime - now;
-    if (remaining <= 0) {
-      countdownMillis = 0;
-      saunaOn = false;
+  bool ok = (entry.weekdays != 0) || (!weekly && (time_t)entry.onceEpoch > now);
+  if (!ok) {
+    request->send(400, "text/plain", "Bad at/days/in");
+    return;
+  }
+
+  bool full = true;
+  for (int id = 0; id < Scheduler::SIZE; id++) {
+    if (!snap.schedule[id].used) full = false;
+  }
+  if (full) {
+    request->send(409, "text/plain", "Schedule full");
+    return;
+  }
+
+  Command command = {};
+  command.type = CMD_SCHEDULE_ADD;
+  command.source = SOURCE_WEB;
+  command.entry = entry;
+  if (!postCommand(command)) return sendBusy(request);
+  request->send(200, "text/plain", "Added");
+}
+
+// /schedule/remove?id=N
+void handleScheduleRemove(AsyncWebServerRequest* request) {
+  int id = request->hasParam("id") ? request->getParam("id")->value().toInt() : -1;
+  ControllerSnapshot snap;
+  readSnapshot(snap);
+  if (id < 0 || id >= Scheduler::SIZE || !snap.schedule[id].used) {
+    request->send(404, "text/plain", "No such entry");
+    return;
+  }
+  if (!postCommand(CMD_SCHEDULE_REMOVE, SOURCE_WEB, id)) return sendBusy(request);
+  request->send(200, "text/plain", "Removed");
+}
+
+// The buffer is static (too big for the async_tcp stack); only that task
+// writes the full status
+void handleStatus(AsyncWebServerRequest* request) {
+  static char json[STATUS_JSON_LEN];
+  if (writeStatusJson(json, sizeof(json), true) < 0) return sendJsonOverflow(request, "/status");
+  request->send(200, "application/json", json);
+}
+
+// /metrics in the Prometheus text format: timing probes, task stack
+// headroom and heap.  Probe averages are also derivable from _sum/_count.
+void handleMetrics(AsyncWebServerRequest* request) {
+  AsyncResponseStream* response = request->beginResponseStream("text/plain; version=0.0.4");
+  PerfStats stats;
+
+  response->print("# HELP sauna_probe_seconds Time spent in instrumented code paths\n"
+                  "# TYPE sauna_probe_seconds summary\n");
+  for (int i = 0; perfRead(i, stats); i++) {
+    response->printf("sauna_probe_seconds{probe=\"%s\",quantile=\"0.99\"} %.6f\n",
+                     stats.name, perfPercentileUs(stats, 0.99f) / 1e6);
+    response->printf("sauna_probe_seconds_sum{probe=\"%s\"} %.6f\n", stats.name, stats.sumUs / 1e6);
+    response->printf("sauna_probe_seconds_count{probe=\"%s\"} %lu\n", stats.name, (unsigned long)stats.count);
+  }
+  response->print("# TYPE sauna_probe_min_seconds gauge\n");
+  for (int i = 0; perfRead(i, stats); i++) {
+    response->printf("sauna_probe_min_seconds{probe=\"%s\"} %.6f\n",
+                     stats.name, stats.count > 0 ? stats.minUs / 1e6 : 0.0);
+  }
+  response->print("# TYPE sauna_probe_avg_seconds gauge\n");
+  for (int i = 0; perfRead(i, stats); i++) {
+    response->printf("sauna_probe_avg_seconds{probe=\"%s\"} %.6f\n",
+                     stats.name, stats.count > 0 ? stats.sumUs / 1e6 / stats.count : 0.0);
+  }
+  response->print("# TYPE sauna_probe_max_seconds gauge\n");
+  for (int i = 0; perfRead(i, stats); i++) {
+    response->printf("sauna_probe_max_seconds{probe=\"%s\"} %.6f\n", stats.name, stats.maxUs / 1e6);
+  }
+
+  response->print("# HELP sauna_task_stack_free_bytes Lowest free stack seen since boot\n"
+                  "# TYPE sauna_task_stack_free_bytes gauge\n");
+  for (const char* name : METRICS_TASKS) {
+    TaskHandle_t task = xTaskGetHandle(name);
+    if (task == NULL) continue;
+    response->printf("sauna_task_stack_free_bytes{task=\"%s\"} %u\n",
+                     name, (unsigned)uxTaskGetStackHighWaterMark(task));
+  }
+
+  response->print("# TYPE sauna_heap_size_bytes gauge\n");
+  response->printf("sauna_heap_size_bytes %u\n", (unsigned)ESP.getHeapSize());
+  response->print("# TYPE sauna_heap_free_bytes gauge\n");
+  response->printf("sauna_heap_free_bytes %u\n", (unsigned)ESP.getFreeHeap());
+  response->print("# TYPE sauna_heap_min_free_bytes gauge\n");
+  response->printf("sauna_heap_min_free_bytes %u\n", (unsigned)ESP.getMinFreeHeap());
+  response->print("# TYPE sauna_heap_largest_block_bytes gauge\n");
+  response->printf("sauna_heap_largest_block_bytes %u\n", (unsigned)ESP.getMaxAllocHeap());
+  response->print("# TYPE sauna_uptime_seconds counter\n");
+  response->printf("sauna_uptime_seconds %lu\n", millis() / 1000);
+
+  request->send(response);
+}
+
+// Wraps a route handler in a timing probe named after the route.  Chunked
+// responses are only timed up to the first chunk; the rest is AsyncTCP's.
+ArRequestHandlerFunction timed(const char* name, ArRequestHandlerFunction handler) {
+  int probe = perfRegister(name);
+  return [probe, handler](AsyncWebServerRequest* request) {
+    PerfTimer timer(probe);
+    handler(request);
+  };
+}
+
+// --- Live status push ---
+int lastPushedTempTenths = -32768;
+int lastPushedSetpointTenths = -32768;
+char lastPushedTime[TIME_STR_LEN] = "";
+bool lastPushedState = false;
+long lastPushedEtaMin = -2;
+
+// Sends the status to every /events client, but only when something a
+// browser shows has changed
+void pushStatusIfChanged() {
+  if (events.count() == 0) return;
+
+  ControllerSnapshot snap;
+  readSnapshot(snap);
+
+  // The page shows whole minutes, so second-by-second drift isn't news
+  long etaMin = snap.etaS < 0 ? -1 : (snap.etaS + 59) / 60;
+  int tempTenths = lroundf(snap.tempF * 10);
+  int setpointTenths = lroundf(snap.setpointF * 10);
+  if (tempTenths == lastPushedTempTenths && snap.saunaOn == lastPushedState &&
+      setpointTenths == lastPushedSetpointTenths && etaMin == lastPushedEtaMin &&
+      strcmp(snap.timeRemaining, lastPushedTime) == 0) {
+    return;
+  }
+  lastPushedEtaMin = etaMin;
+  lastPushedTempTenths = tempTenths;
+  lastPushedSetpointTenths = setpointTenths;
+  lastPushedState = snap.saunaOn;
+  strlcpy(lastPushedTime, snap.timeRemaining, sizeof(lastPushedTime));
+
+  char json[LIVE_JSON_LEN];
+  if (writeStatusJson(json, sizeof(json), false) < 0) {
+    Serial.println("/events JSON did not fit its buffer");
+    return;
+  }
+  events.send(json, "status", millis());
+}
+
+// --- Non-blocking temperature read, one per sampleProfile.periodMs ---
+// Alternates between starting a conversion and collecting its result.  The
+// wait is the conversion time for the current resolution, not a fixed 750.
+void serviceTemperature() {
+  if (!tempConversionInProgress) {
+    probesRequest();
+    tempRequestTime = millis();
+    tempConversionInProgress = true;
+    armTimer(tempTimer, probesConversionMs());
+  } else if (probesReady()) {
+    {
+      PerfTimer timer(tempReadProbe);
+      probesRead();
+    }
+    currentTempF = controlTempF();
+    float hottestF = DEVICE_DISCONNECTED_F;
+    for (int i = 0; i < probeCount(); i++) {
+      float t = probe(i).tempF;
+      if (t != DEVICE_DISCONNECTED_F && (hottestF == DEVICE_DISCONNECTED_F || t > hottestF)) hottestF = t;
+    }
+    safetyReportTemps(currentTempF, hottestF);
+    tempConversionInProgress = false;
+
+    // Once per outage, not once per failed read
+    bool faulted = currentTempF == DEVICE_DISCONNECTED_F;
+    if (faulted && !sensorFaultNotified && probesHaveControl()) {
+      sendNotification(NOTIFY_SENSOR_FAULT, "⚠️ Temperature probe not responding, heater held off");
+    }
+    sensorFaultNotified = faulted;
+
+    if (faulted) {
+      thermostat.fault();   // Never heat blind
+    } else if (autotune.getState() == AUTOTUNE_RUNNING) {
+      thermostat.setOutput(autotune.update(currentTempF, millis()));
+      if (autotune.getState() != AUTOTUNE_RUNNING) finishAutotune();
     } else {
-      countdownMillis = remaining;
+      thermostat.update(currentTempF, millis());
     }
+    trackSession(currentTempF, millis());
+
+    // Autotune needs fine samples throughout to see its peaks
+    bool holding = autotune.getState() == AUTOTUNE_RUNNING;
+    sampleProfile = holding ? SAMPLE_HOLDING
+                            : chooseSampleProfile(sampleProfile, saunaOn, currentTempF, targetTempF);
+    probesSetResolution(min((int32_t)sampleProfile.resolution, settings.maxResolution));
+
+    unsigned long period = idle ? IDLE_SAMPLE_MS : sampleProfile.periodMs;
+    unsigned long elapsed = millis() - tempRequestTime;
+    armTimer(tempTimer, elapsed < period ? period - elapsed : 0);
+  } else {
+    armTimer(tempTimer, 10);   // Nearly done; check again shortly
+  }
+}
+
+// Wakes loop() when the mm:ss display next changes or the countdown ends
+void scheduleCountdownTick() {
+  if (saunaOn && countdown.remainingMs() > 0) {
+    armTimer(countdownTimer, countdown.msToNextSecond());
+  } else {
+    xTimerStop(countdownTimer, 0);
+  }
+}
+
+// Sauna off and nobody about: backlight off, one conversion a minute and
+// the CPU clocked down.  Input is interrupt-driven anyway.  WiFi keeps its default
+// modem sleep (radio off between DTIM beacons), which leaves the web
+// server and MQTT answering as fast as ever.
+void enterIdle() {
+  idle = true;              // serviceTemperature() stretches the next wait
+  displaySetAwake(false);
+  awakeCpuMhz = getCpuFrequencyMhz();
+  setCpuFrequencyMhz(IDLE_CPU_MHZ);
+  Serial.println("Idle: power saving on");
+}
+
+void leaveIdle(unsigned long now) {
+  lastActivityMs = now;
+  if (!idle) return;
+  idle = false;
+  setCpuFrequencyMhz(awakeCpuMhz);
+  displaySetAwake(true);
+  // A fresh reading straight away, well inside the sensor timeout of a
+  // session starting from idle
+  armTimer(tempTimer, 0);
+  Serial.println("Idle: awake");
+}
+
+// Called at the end of every loop() pass, which is at least once a second
+void serviceIdle(unsigned long now) {
+  if (saunaOn || autotune.getState() == AUTOTUNE_RUNNING) {
+    leaveIdle(now);   // A scheduled start, say
+  } else if (!idle && settings.idleMin > 0 && now - lastActivityMs >= settings.idleMin * 60000UL) {
+    enterIdle();
   }
+}
+
+void setup() {
+  // --- Initialize sensors, lcd, and encoder
+  Serial.begin(9600);
+  delay(1000); // give time for Serial
 
-  // --- Update LCD every 200ms ---
-  if (now - lastLCDUpdate >= 200) {
-    lastLCDUpdate = now;
-    updateStateAndDisplay();
+  // SSR low before anything else; the supervisor owns the pin from here
+  safetyBegin(SSR_PIN, []() { wakeLoop(WAKE_SAFETY); });
+
+  settingsBegin();
+  loadEnergy(energyMeter);
+  loopProbe = perfRegister("loop");
+  displayProbe = perfRegister("display");
+  tempReadProbe = perfRegister("temp_read");
+  controllerBegin();
+
+  // setup() and loop() share a task; everything below may wake it
+  wakeBegin();
+  tempTimer = xTimerCreate("temp", 1, pdFALSE, NULL,
+                           [](TimerHandle_t) { wakeLoop(WAKE_TEMP); });
+  countdownTimer = xTimerCreate("countdown", 1, pdFALSE, NULL,
+                                [](TimerHandle_t) { wakeLoop(WAKE_COUNTDOWN); });
+  heaterTimer = xTimerCreate("heater", 1, pdFALSE, NULL,
+                             [](TimerHandle_t) { wakeLoop(WAKE_HEATER); });
+  historyTimer = xTimerCreate("history", pdMS_TO_TICKS(1000), pdTRUE, NULL,
+                              [](TimerHandle_t) { wakeLoop(WAKE_HISTORY); });
+  xTimerStart(historyTimer, 0);
+  targetTempF = settings.setpointF;
+  thermostat.setSetpoint(targetTempF);
+  PidGains savedGains;
+  if (loadGains(savedGains)) {
+    thermostat.setGains(savedGains);
+    Serial.printf("Loaded PID gains Kp=%.3f Ki=%.5f Kd=%.2f\n", savedGains.kp, savedGains.ki, savedGains.kd);
+  }
+  if (loadSchedule(scheduler)) {
+    Serial.println("Loaded scheduled starts.");
   }
 
-  // Free up the processor for a short time
-  delay(10);
+  // Set up encoder and button events
+  inputBegin(ENCODER_A, ENCODER_B, ENCODER_SW);
+
+  // Set up lcd and its render task
+  displayBegin();
+
+  probesBegin(ONE_WIRE_BUS, min((int32_t)sampleProfile.resolution, settings.maxResolution));
+  applyProbeRoles();
+
+  // A freshly updated image stays only if it can see a probe and the
+  // supervisor is ticking; otherwise this reboots into the previous one
+  otaSelfTest(probeCount() > 0);
+
+  // --- Start the background Discord sender before anything can notify
+  notifierBegin();
+
+  // Start the session log task (it mounts flash) before a session can end
+  sessionLogBegin();
+
+  // --- Join primary or secondary WiFi in the background (credentials in
+  // secrets.h); the encoder and LCD work meanwhile, and the IP shows once up
+  wifiManagerBegin(showIP);
+  mqttBegin();   // Connects whenever WiFi is up
+  otaBegin([]() {
+    // The supervisor already holds the SSR low; end the session cleanly too
+    postCommand(CMD_OFF, SOURCE_OTA);
+    displayOverlay("Firmware update", "Heater off", 0);
+  });
+
+  // Wall clock for the scheduler; SNTP keeps retrying until it gets through
+  configTzTime(TIME_ZONE, NTP_SERVER_1, NTP_SERVER_2);
+
+  // -- Register website paths
+  server.on("/", HTTP_GET, timed("GET /", handleRoot));
+  server.on("/config.json", HTTP_GET, timed("GET /config.json", handleConfigJson));
+  server.on("/config", HTTP_GET, timed("GET /config", handleConfigPage));
+  server.on("/config", HTTP_POST, timed("POST /config", handleConfigSave));
+  server.on("/on", HTTP_GET, timed("GET /on", handleOn));
+  server.on("/off", HTTP_GET, timed("GET /off", handleOff));
+  server.on("/addtime", HTTP_GET, timed("GET /addtime", handleAddTime));
+  server.on("/setpoint", HTTP_GET, timed("GET /setpoint", handleSetpoint));
+  server.on("/autotune", HTTP_GET, timed("GET /autotune", handleAutotune));
+  server.on("/history.bin", HTTP_GET, timed("GET /history.bin", handleHistoryBinary));
+  server.on("/history", HTTP_GET, timed("GET /history", handleHistory));
+  server.on("/sessions", HTTP_GET, timed("GET /sessions", handleSessions));
+  // Sub-paths first: "/schedule" would also match "/schedule/add"
+  server.on("/schedule/add", HTTP_GET, timed("GET /schedule/add", handleScheduleAdd));
+  server.on("/schedule/remove", HTTP_GET, timed("GET /schedule/remove", handleScheduleRemove));
+  server.on("/schedule", HTTP_GET, timed("GET /schedule", handleSchedule));
+  server.on("/status", HTTP_GET, timed("GET /status", handleStatus));
+  server.on("/metrics", HTTP_GET, timed("GET /metrics", handleMetrics));
+  server.on("/update", HTTP_POST, timed("POST /update", otaHandleUpdateDone), otaHandleUpload);
+  events.onConnect([](AsyncEventSourceClient* client) {
+    // Bring a new page up to date without waiting for the next change
+    char json[LIVE_JSON_LEN];
+    if (writeStatusJson(json, sizeof(json), false) >= 0) client->send(json, "status");
+  });
+  server.addHandler(&events);
+  server.onNotFound([](AsyncWebServerRequest* request) {
+    request->send(404, "text/plain", "Not found");
+  });
+  publishState();   // Handlers may read it as soon as the server is up
+  server.begin();
+
+  updateStateAndDisplay();
+  serviceTemperature();   // Kicks off the first conversion
+}
+
+void loop() {
+  // Sleep until a timer, the input task or a web handler has news
+  uint32_t reasons = waitForWake(pdMS_TO_TICKS(LOOP_IDLE_MAX_MS));
+  PerfTimer timer(loopProbe);   // One pass, not counting the sleep
+  unsigned long now = millis();
+  safetyLoopAlive();
+
+  if (reasons & WAKE_SAFETY) {
+    // The SSR is already off; end the session so the trip can clear
+    SafetyTrip trip = safetyTripped();
+    if (saunaOn) {
+      sessionEndReason = SESSION_END_FAULT;
+      saunaOn = false;
+      countdown.set(0);
+    }
+    if (trip != SAFETY_OK) {
+      leaveIdle(now);
+      displayOverlay("SAFETY CUTOFF", safetyTripName(trip), 10000);
+      NotifyEvent event = trip == SAFETY_OVER_TEMP      ? NOTIFY_OVER_TEMP
+                        : trip == SAFETY_SENSOR_TIMEOUT ? NOTIFY_SENSOR_FAULT
+                                                        : NOTIFY_SAFETY;
+      sendNotification(event, String("⚠️ Safety cutoff: ") + safetyTripName(trip) + ", heater off");
+    }
+  }
+
+  if (reasons & WAKE_TEMP) {
+    serviceTemperature();
+  }
+
+  if (reasons & WAKE_HISTORY) {
+    // Latest reading, once a second whatever the sampling rate
+    history.add(currentTempF, currentTempF != DEVICE_DISCONNECTED_F, now / 1000);
+    feedThermalModel();
+    updateEnergy();
+    serviceSchedule(now);
+  }
+
+  // --- Requests from other tasks ---
+  Command command;
+  while (pollCommand(command)) {
+    leaveIdle(now);
+    applyCommand(command, now);
+  }
+  SettingChange change;
+  while (pollSetting(change)) {
+    applySetting(change);
+  }
+
+  // --- Encoder and button events ---
+  InputEvent input;
+  while (inputPoll(input)) {
+    if (idle) {
+      leaveIdle(now);
+      continue;   // The touch that wakes it does nothing else
+    }
+    lastActivityMs = now;
+    if (settingsItem >= 0) {
+      handleSettingsInput(input);
+    } else if (probeItem >= 0) {
+      handleProbesInput(input);
+    } else if (input.type == INPUT_ROTATE) {
+      menu.rotate(input.delta, settings.maxTimeMin);
+    } else if (input.type == INPUT_LONG_PRESS) {
+      // Long press backs out of time setting without applying it
+      menu.longPress();
+    } else if (menu.press() == MENU_TIME_SET) {
+      countdown.set(menu.minutes() * 60000UL);
+    } else {
+      String selected = menu.label();
+      if (selected == "Start") {
+        applyCommand({ CMD_START, SOURCE_MENU, 0 }, now);
+      } else if (selected == "Stop") {
+        applyCommand({ CMD_STOP, SOURCE_MENU, 0 }, now);
+      } else if (selected == "Set" && !saunaOn) {
+        menu.beginSetTime();
+      } else if (selected == "Tune") {
+        bool running = autotune.getState() == AUTOTUNE_RUNNING;
+        applyCommand({ running ? CMD_AUTOTUNE_CANCEL : CMD_AUTOTUNE, SOURCE_MENU, 0 }, now);
+      } else if (selected == "Sched") {
+        showSchedule();
+      } else if (selected == "Temps") {
+        showProbes();
+      } else if (selected == "Probes") {
+        probeItem = 0;
+        editingRole = false;
+        showProbesMenu();
+      } else if (selected == "IP") {
+        showIP();
+      } else if (selected == "Settings") {
+        settingsItem = 0;
+        editingSetting = false;
+        showSettingsMenu();
+      }
+    }
+  }
+   
+  // --- Countdown logic ---
+  if (saunaOn && countdown.remainingMs() > 0 && countdown.update(now)) {
+    sessionEndReason = SESSION_END_TIMER;
+    saunaOn = false;
+  }
+  scheduleCountdownTick();
+  serviceIdle(now);
+
+  // Every wake is a potential change; the pushes skip unchanged output
+  updateStateAndDisplay();
+  applyHeater(now);
+  publishState();
+  pushStatusIfChanged();
 }
\ No newline at end of file
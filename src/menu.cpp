@@ -0,0 +1,20 @@
+#include "menu.h"
+
+// Wraps value into 0..span-1, whichever way it went out
+static int wrap(int value, int span) {
+  return (value % span + span) % span;
+}
+
+void Menu::rotate(int delta, int maxMinutes) {
+  if (settingTime) {
+    setMinutes = wrap(setMinutes + delta, maxMinutes + 1);
+  } else {
+    index = wrap(index + delta, count);
+  }
+}
+
+MenuAction Menu::press() {
+  if (!settingTime) return MENU_SELECTED;
+  settingTime = false;
+  return MENU_TIME_SET;
+}
@@ -0,0 +1,298 @@
+#include <limits.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+#include <secrets.h>
+#include "mqtt_bridge.h"
+#include "controller.h"
+
+#ifdef MQTT_HOST
+#define MQTT_ENABLED true
+#else
+#define MQTT_ENABLED false
+#define MQTT_HOST ""
+#endif
+#ifndef MQTT_PORT
+#define MQTT_PORT 1883
+#endif
+// Either may be left out: a user with no password, or neither
+#ifndef MQTT_USER
+#define MQTT_USER nullptr
+#endif
+#ifndef MQTT_PWD
+#define MQTT_PWD nullptr
+#endif
+
+#define MQTT_DISCOVERY_PREFIX "homeassistant"
+
+// Only the MQTT task touches the client and the topic buffers
+static WiFiClient mqttSocket;
+static PubSubClient mqtt(mqttSocket);
+static char deviceId[16];         // "sauna_a1b2c3"
+static char baseTopic[32];        // "sauna/sauna_a1b2c3"
+
+static QueueHandle_t eventQueue = NULL;
+
+static volatile bool connectedNow = false;
+static volatile unsigned long connectCount = 0;
+static volatile unsigned long publishCount = 0;
+static volatile unsigned long commandCount = 0;
+
+// --- What was last published, to skip unchanged state ---
+struct Published {
+  int tempTenths;
+  int setpointTenths;
+  bool on;
+  bool heater;
+  long minutesLeft;
+  long etaMin;
+};
+
+static void topic(char* buf, size_t len, const char* suffix) {
+  snprintf(buf, len, "%s/%s", baseTopic, suffix);
+}
+
+// --- Home Assistant discovery ---
+// One retained config per entity, all grouped under one device.  Buttons
+// are stateless, and Home Assistant rejects a state_topic on one.
+static void publishDiscovery(const char* component, const char* object, const char* extra) {
+  char configTopic[96];
+  char stateTopic[80] = "";
+  char payload[MQTT_BUFFER_SIZE];
+  snprintf(configTopic, sizeof(configTopic), MQTT_DISCOVERY_PREFIX "/%s/%s/%s/config",
+           component, deviceId, object);
+  if (strcmp(component, "button") != 0) {
+    snprintf(stateTopic, sizeof(stateTopic), "\"state_topic\":\"%s/state\",", baseTopic);
+  }
+  snprintf(payload, sizeof(payload),
+           "{\"name\":\"%s\",\"unique_id\":\"%s_%s\",\"object_id\":\"%s_%s\","
+           "\"availability_topic\":\"%s/availability\",%s%s,"
+           "\"device\":{\"identifiers\":[\"%s\"],\"name\":\"Sauna\",\"model\":\"ESP32 Sauna Controller\"}}",
+           object, deviceId, object, deviceId, object, baseTopic, stateTopic, extra, deviceId);
+  mqtt.publish(configTopic, payload, true);
+}
+
+static void announce() {
+  char extra[256];
+
+  publishDiscovery("sensor", "temperature",
+      "\"device_class\":\"temperature\",\"unit_of_measurement\":\"°F\","
+      "\"value_template\":\"{{ value_json.temp }}\"");
+
+  snprintf(extra, sizeof(extra),
+      "\"command_topic\":\"%s/set/power\",\"value_template\":\"{{ value_json.power }}\","
+      "\"icon\":\"mdi:hot-tub\"", baseTopic);
+  publishDiscovery("switch", "power", extra);
+
+  snprintf(extra, sizeof(extra),
+      "\"command_topic\":\"%s/set/setpoint\",\"value_template\":\"{{ value_json.setpoint }}\","
+      "\"min\":%g,\"max\":%g,\"step\":1,\"unit_of_measurement\":\"°F\",\"mode\":\"box\"",
+      baseTopic, SETPOINT_MIN_F, SETPOINT_MAX_F);
+  publishDiscovery("number", "setpoint", extra);
+
+  snprintf(extra, sizeof(extra),
+      "\"command_topic\":\"%s/set/addtime\",\"payload_press\":\"PRESS\",\"icon\":\"mdi:timer-plus\"", baseTopic);
+  publishDiscovery("button", "add_time", extra);
+
+  publishDiscovery("sensor", "remaining",
+      "\"unit_of_measurement\":\"min\",\"icon\":\"mdi:timer-sand\","
+      "\"value_template\":\"{{ value_json.remaining }}\"");
+
+  // eta is null when there's no estimate; a sensor with a unit must not be
+  // handed that, so it renders None, which Home Assistant shows as unknown
+  publishDiscovery("sensor", "eta",
+      "\"unit_of_measurement\":\"min\",\"icon\":\"mdi:clock-fast\","
+      "\"value_template\":\"{{ value_json.eta if value_json.eta is not none else None }}\"");
+
+  publishDiscovery("binary_sensor", "heater",
+      "\"device_class\":\"heat\",\"value_template\":\"{{ value_json.heater }}\"");
+}
+
+// Commands are queued for loop() exactly like the web handlers' are
+static void onMessage(char* fullTopic, byte* payload, unsigned int length) {
+  char value[16];
+  size_t n = length < sizeof(value) - 1 ? length : sizeof(value) - 1;
+  memcpy(value, payload, n);
+  value[n] = '\0';
+
+  size_t base = strlen(baseTopic);
+  if (strncmp(fullTopic, baseTopic, base) != 0) return;
+  const char* suffix = fullTopic + base;
+
+  bool queued = false;
+  if (strcmp(suffix, "/set/power") == 0) {
+    if (strcasecmp(value, "ON") == 0) queued = postCommand(CMD_ON, SOURCE_MQTT);
+    else if (strcasecmp(value, "OFF") == 0) queued = postCommand(CMD_OFF, SOURCE_MQTT);
+  } else if (strcmp(suffix, "/set/setpoint") == 0) {
+    float setpoint = atof(value);
+    if (setpoint > 0) queued = postCommand(CMD_SETPOINT, SOURCE_MQTT, setpoint);
+  } else if (strcmp(suffix, "/set/addtime") == 0) {
+    int minutes = atoi(value);
+    queued = postCommand(CMD_ADD_TIME, SOURCE_MQTT, minutes > 0 ? minutes : 0);   // 0 = the setting
+  }
+  if (queued) commandCount++;
+}
+
+static bool connectBroker() {
+  char willTopic[48];
+  char commandTopic[48];
+  topic(willTopic, sizeof(willTopic), "availability");
+  if (!mqtt.connect(deviceId, MQTT_USER, MQTT_PWD, willTopic, 0, true, "offline")) {
+    return false;
+  }
+
+  connectCount++;
+  mqtt.publish(willTopic, "online", true);
+  topic(commandTopic, sizeof(commandTopic), "set/#");
+  mqtt.subscribe(commandTopic);
+  announce();
+  return true;
+}
+
+// One JSON message carries every field, so a change costs one publish
+static void publishState(const ControllerSnapshot& snap, Published& last) {
+  char stateTopic[48];
+  char payload[256];
+  topic(stateTopic, sizeof(stateTopic), "state");
+
+  long minutesLeft = (snap.countdownMs + 59999) / 60000;
+  long etaMin = snap.etaS < 0 ? -1 : (snap.etaS + 59) / 60;
+  int n = snprintf(payload, sizeof(payload),
+                   "{\"temp\":%.1f,\"setpoint\":%.1f,\"power\":\"%s\",\"heater\":\"%s\","
+                   "\"remaining\":%ld,\"time\":\"%s\",\"eta\":",
+                   snap.tempF, snap.setpointF, snap.saunaOn ? "ON" : "OFF",
+                   snap.heaterOn ? "ON" : "OFF", minutesLeft, snap.timeRemaining);
+  if (etaMin >= 0) {
+    snprintf(payload + n, sizeof(payload) - n, "%ld}", etaMin);
+  } else {
+    snprintf(payload + n, sizeof(payload) - n, "null}");
+  }
+
+  if (mqtt.publish(stateTopic, payload, true)) {
+    publishCount++;
+    last.tempTenths = lroundf(snap.tempF * 10);
+    last.setpointTenths = lroundf(snap.setpointF * 10);
+    last.on = snap.saunaOn;
+    last.heater = snap.heaterOn;
+    last.minutesLeft = minutesLeft;
+    last.etaMin = etaMin;
+  }
+}
+
+// Copies text into a JSON string body, escaping quotes and control chars
+static void jsonEscape(char* out, size_t len, const char* text) {
+  size_t n = 0;
+  for (const char* p = text; *p && n + 7 < len; p++) {
+    if (*p == '"' || *p == '\\') {
+      out[n++] = '\\';
+      out[n++] = *p;
+    } else if ((uint8_t)*p < 0x20) {
+      n += snprintf(out + n, len - n, "\\u%04x", *p);
+    } else {
+      out[n++] = *p;
+    }
+  }
+  out[n] = '\0';
+}
+
+// Not retained: an event is news once, not state
+static bool publishEvent(const NotifyMessage& msg) {
+  char eventTopic[48];
+  char escaped[NOTIFY_MAX_MESSAGE * 2];
+  char payload[NOTIFY_MAX_MESSAGE * 2 + 48];
+  topic(eventTopic, sizeof(eventTopic), "event");
+  jsonEscape(escaped, sizeof(escaped), msg.text);
+  snprintf(payload, sizeof(payload), "{\"event\":\"%s\",\"message\":\"%s\"}",
+           notifyEventName((NotifyEvent)msg.event), escaped);
+  if (!mqtt.publish(eventTopic, payload, false)) return false;
+  publishCount++;
+  return true;
+}
+
+static bool changed(const ControllerSnapshot& snap, const Published& last) {
+  // Whole minutes only; the HA entities don't show seconds
+  long etaMin = snap.etaS < 0 ? -1 : (snap.etaS + 59) / 60;
+  return lroundf(snap.tempF * 10) != last.tempTenths ||
+         lroundf(snap.setpointF * 10) != last.setpointTenths ||
+         snap.saunaOn != last.on || snap.heaterOn != last.heater ||
+         (long)((snap.countdownMs + 59999) / 60000) != last.minutesLeft ||
+         etaMin != last.etaMin;
+}
+
+static void mqttTask(void* param) {
+  unsigned long retryMs = MQTT_RETRY_MS;
+  unsigned long lastAttempt = 0;
+  bool everTried = false;
+  unsigned long lastPublish = 0;
+  Published last = { INT_MIN, INT_MIN, false, false, -2, -2 };
+
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(MQTT_POLL_MS));
+
+    if (!mqtt.connected()) {
+      connectedNow = false;
+      if (WiFi.status() != WL_CONNECTED) continue;
+      if (everTried && millis() - lastAttempt < retryMs) continue;
+
+      everTried = true;
+      lastAttempt = millis();
+      if (!connectBroker()) {
+        Serial.printf("MQTT: connect failed (%d), retrying in %lu s\n", mqtt.state(), retryMs / 1000);
+        retryMs = min(retryMs * 2, (unsigned long)MQTT_RETRY_MAX_MS);
+        continue;
+      }
+      Serial.println("MQTT: connected");
+      connectedNow = true;
+      retryMs = MQTT_RETRY_MS;
+      last.tempTenths = INT_MIN;   // Republish everything on a new session
+    }
+
+    mqtt.loop();   // Keepalive and incoming commands
+
+    // Left queued if the publish fails, so a dropped link doesn't lose it
+    NotifyMessage event;
+    while (xQueuePeek(eventQueue, &event, 0) == pdTRUE && publishEvent(event)) {
+      xQueueReceive(eventQueue, &event, 0);
+    }
+
+    ControllerSnapshot snap;
+    readSnapshot(snap);
+    unsigned long now = millis();
+    bool due = changed(snap, last) ? now - lastPublish >= MQTT_MIN_PUBLISH_MS
+                                   : now - lastPublish >= MQTT_REFRESH_MS;
+    if (due) {
+      publishState(snap, last);
+      lastPublish = now;
+    }
+  }
+}
+
+void mqttBegin() {
+  if (!MQTT_ENABLED) return;
+
+  uint8_t mac[6];
+  WiFi.macAddress(mac);
+  snprintf(deviceId, sizeof(deviceId), "sauna_%02x%02x%02x", mac[3], mac[4], mac[5]);
+  snprintf(baseTopic, sizeof(baseTopic), "sauna/%s", deviceId);
+
+  mqtt.setServer(MQTT_HOST, MQTT_PORT);
+  mqtt.setBufferSize(MQTT_BUFFER_SIZE);
+  mqtt.setCallback(onMessage);
+  eventQueue = xQueueCreate(MQTT_EVENT_QUEUE_LENGTH, sizeof(NotifyMessage));
+  xTaskCreatePinnedToCore(mqttTask, "mqtt", MQTT_TASK_STACK, NULL,
+                          MQTT_TASK_PRIORITY, NULL, MQTT_TASK_CORE);
+}
+
+MqttStats mqttGetStats() {
+  MqttStats stats;
+  stats.enabled = MQTT_ENABLED;
+  stats.connected = connectedNow;
+  stats.connects = connectCount;
+  stats.publishes = publishCount;
+  stats.commands = commandCount;
+  return stats;
+}
+
+bool mqttPublishEvent(const NotifyMessage& msg) {
+  if (eventQueue == NULL || !connectedNow) return false;
+  return xQueueSend(eventQueue, &msg, 0) == pdTRUE;
+}
@@ -0,0 +1,346 @@
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+#include <secrets.h>
+#include "notifier.h"
+#include "mqtt_bridge.h"
+#include "settings.h"
+#include "perf.h"
+
+#ifdef NTFY_URL
+#define NTFY_ENABLED true
+#else
+#define NTFY_ENABLED false
+#define NTFY_URL ""
+#endif
+
+// --- Task setup ---
+#define NOTIFY_TASK_STACK 8192      // TLS needs a deep stack
+#define NOTIFY_TASK_PRIORITY 1
+#define NOTIFY_TASK_CORE 0          // loop() runs on core 1
+
+static QueueHandle_t notifyQueue = NULL;
+static volatile unsigned long droppedCount = 0;
+static volatile unsigned long coalescedCount = 0;
+
+// Only the notifier task touches the rules, the sinks and the clients
+// below, so no locking is needed.
+static NotifyCoalescer coalescer;
+
+// --- Long-lived webhook connection ---
+static WiFiClientSecure webhookClient;
+static HTTPClient webhookHttp;
+static const char* DISCORD_HEADERS[] = { "Retry-After", "X-RateLimit-Remaining", "X-RateLimit-Reset-After" };
+
+static WiFiClientSecure ntfySecureClient;
+static WiFiClient ntfyClient;
+
+// --- Timing probes ---
+static int queueProbe = -1;
+static int postProbe = -1;
+
+// Delivers one message.  Returns the HTTP code (<= 0 on transport errors)
+// and may ask for a pause before the next delivery through waitMs.
+typedef int (*SinkPost)(const NotifyMessage& msg, unsigned long& waitMs);
+
+struct Sink {
+  const char* name;
+  bool enabled;
+  const char* eventList;      // The sink's event-list setting
+  SinkPost post;
+
+  // Outbox ring; the head is retried until it goes or runs out of attempts
+  NotifyMessage outbox[NOTIFY_OUTBOX_LENGTH];
+  int head;
+  int count;
+  int attempts;
+  unsigned long backoffMs;
+  unsigned long nextAttemptMs;
+
+  volatile unsigned long handshakes;
+  volatile unsigned long sent;
+  volatile unsigned long totalSendMs;
+  volatile unsigned long dropped;
+  volatile unsigned long rateLimited;
+};
+
+static Sink sinks[NOTIFY_SINK_COUNT];
+
+// Builds the Discord JSON body, escaping anything that would break the string
+static String buildPayload(const char* text) {
+  String payload = "{\"content\": \"";
+  for (const char* p = text; *p; p++) {
+    if (*p == '"' || *p == '\\') {
+      payload += '\\';
+      payload += *p;
+    } else if (*p == '\n') {
+      payload += "\\n";
+    } else {
+      payload += *p;
+    }
+  }
+  payload += "\"}";
+  return payload;
+}
+
+// A header holding (possibly fractional) seconds, in ms; 0 if absent
+static unsigned long headerMs(HTTPClient& http, const char* name) {
+  String value = http.header(name);
+  return value.length() > 0 ? (unsigned long)(value.toFloat() * 1000.0f) : 0;
+}
+
+// Runs one blocking POST over the kept-alive connection, reconnecting only
+// when Discord (or the WiFi link) has dropped it
+static int postDiscord(const NotifyMessage& msg, unsigned long& waitMs) {
+  if (!webhookClient.connected()) {
+    sinks[NOTIFY_SINK_DISCORD].handshakes++;
+  }
+
+  webhookHttp.begin(webhookClient, DISCORD_WEBHOOK_URL);
+  webhookHttp.addHeader("Content-Type", "application/json");
+  int httpResponseCode = webhookHttp.POST(buildPayload(msg.text));
+
+  if (httpResponseCode == 429) {
+    // The body's retry_after is finer grained than the header when present
+    waitMs = headerMs(webhookHttp, "Retry-After");
+    String body = webhookHttp.getString();
+    int at = body.indexOf("\"retry_after\"");
+    int colon = at >= 0 ? body.indexOf(':', at) : -1;
+    if (colon >= 0) waitMs = (unsigned long)(body.substring(colon + 1).toFloat() * 1000.0f);
+  } else if (webhookHttp.header("X-RateLimit-Remaining") == "0") {
+    // Bucket used up: wait for it to refill rather than earn a 429
+    waitMs = headerMs(webhookHttp, "X-RateLimit-Reset-After");
+  }
+  webhookHttp.end();   // Keeps the socket open since reuse is enabled
+
+  if (httpResponseCode <= 0) {
+    // Half-open socket or failed handshake; start clean on the next try
+    webhookClient.stop();
+  }
+  return httpResponseCode;
+}
+
+// ntfy takes the text as the body and everything else as headers
+static int postNtfy(const NotifyMessage& msg, unsigned long& waitMs) {
+  NotifyEvent event = (NotifyEvent)msg.event;
+  HTTPClient http;
+  if (strncmp(NTFY_URL, "https", 5) == 0) {
+    sinks[NOTIFY_SINK_NTFY].handshakes++;
+    http.begin(ntfySecureClient, NTFY_URL);
+  } else {
+    http.begin(ntfyClient, NTFY_URL);
+  }
+  http.addHeader("Title", "Sauna");
+  http.addHeader("Tags", notifyEventName(event));
+  if (notifyUrgent(event)) http.addHeader("Priority", "urgent");
+#ifdef NTFY_TOKEN
+  http.addHeader("Authorization", "Bearer " NTFY_TOKEN);
+#endif
+  int httpResponseCode = http.POST((uint8_t*)msg.text, strlen(msg.text));
+  if (httpResponseCode == 429) waitMs = headerMs(http, "Retry-After");
+  http.end();
+  return httpResponseCode;
+}
+
+// Hands the message to the MQTT task.  Reported as a transport error
+// while the broker is unreachable, so it's retried like a failed POST.
+static int postMqtt(const NotifyMessage& msg, unsigned long& waitMs) {
+  return mqttPublishEvent(msg) ? 200 : -1;
+}
+
+// Transport errors, rate limiting and server errors are worth another try.
+// Anything else (bad webhook, malformed body) will never succeed.
+static bool isRetryable(int httpResponseCode) {
+  return httpResponseCode <= 0 || httpResponseCode == 429 || httpResponseCode >= 500;
+}
+
+// A list that fails to parse (it's validated on save) means all events
+static bool wants(const Sink& sink, NotifyEvent event) {
+  char list[SETTING_EVENTS_LEN];
+  settingCopyText(sink.eventList, list, sizeof(list));
+  uint32_t mask;
+  if (!parseNotifyEvents(list, mask)) mask = NOTIFY_ALL_EVENTS;
+  return mask & (1UL << event);
+}
+
+static void popOutbox(Sink& sink) {
+  sink.head = (sink.head + 1) % NOTIFY_OUTBOX_LENGTH;
+  sink.count--;
+  sink.attempts = 0;
+  sink.backoffMs = NOTIFY_BACKOFF_MS;
+}
+
+// Copies a message into the outbox of every sink that wants it
+static void dispatch(const NotifyMessage& msg) {
+  for (int i = 0; i < NOTIFY_SINK_COUNT; i++) {
+    Sink& sink = sinks[i];
+    if (!sink.enabled || !wants(sink, (NotifyEvent)msg.event)) continue;
+
+    if (sink.count == NOTIFY_OUTBOX_LENGTH) {
+      popOutbox(sink);   // A fresh "OFF" beats a stale "ON"
+      sink.dropped++;
+      droppedCount++;
+      Serial.printf("Notify: %s outbox full, dropped oldest message.\n", sink.name);
+    }
+    sink.outbox[(sink.head + sink.count) % NOTIFY_OUTBOX_LENGTH] = msg;
+    sink.count++;
+  }
+}
+
+// Makes at most one delivery attempt for the sink's oldest message
+static void serviceSink(Sink& sink) {
+  unsigned long now = millis();
+  if (sink.count == 0 || (long)(now - sink.nextAttemptMs) < 0) return;
+
+  // Wait for the network rather than burning attempts while it's down
+  if (WiFi.status() != WL_CONNECTED) {
+    sink.nextAttemptMs = now + NOTIFY_BACKOFF_MS;
+    return;
+  }
+
+  // micros(), not the cycle counter: a slow handshake can outlast its wrap
+  unsigned long waitMs = 0;
+  unsigned long startUs = micros();
+  int httpResponseCode = sink.post(sink.outbox[sink.head], waitMs);
+  unsigned long tookUs = micros() - startUs;
+  perfRecordUs(postProbe, tookUs);
+  now = millis();
+  waitMs = min(waitMs, (unsigned long)NOTIFY_RETRY_AFTER_MAX_MS);
+
+  if (httpResponseCode >= 200 && httpResponseCode < 300) {
+    sink.sent++;
+    sink.totalSendMs += tookUs / 1000;
+    popOutbox(sink);
+    sink.nextAttemptMs = now + waitMs;
+    return;
+  }
+
+  if (httpResponseCode == 429) {
+    // Told how long to wait, so this doesn't count as a failed attempt
+    sink.rateLimited++;
+    if (waitMs == 0) {
+      waitMs = sink.backoffMs;
+      sink.backoffMs = min(sink.backoffMs * 2, (unsigned long)NOTIFY_BACKOFF_MAX_MS);
+    }
+    sink.nextAttemptMs = now + waitMs;
+    Serial.printf("Notify: %s rate limited, waiting %lu ms\n", sink.name, waitMs);
+    return;
+  }
+
+  sink.attempts++;
+  Serial.printf("Notify: %s failed (attempt %d).  HTTP error: %d\n", sink.name, sink.attempts, httpResponseCode);
+  if (!isRetryable(httpResponseCode) || sink.attempts >= NOTIFY_MAX_ATTEMPTS) {
+    sink.dropped++;
+    droppedCount++;
+    popOutbox(sink);
+    return;
+  }
+  sink.nextAttemptMs = now + sink.backoffMs;
+  sink.backoffMs = min(sink.backoffMs * 2, (unsigned long)NOTIFY_BACKOFF_MAX_MS);
+}
+
+// How long the task can sleep before a window closes or a retry is due
+static TickType_t idleTicks() {
+  unsigned long now = millis();
+  unsigned long wait = coalescer.msUntilDue(now);
+  for (int i = 0; i < NOTIFY_SINK_COUNT; i++) {
+    const Sink& sink = sinks[i];
+    if (sink.count == 0) continue;
+    long left = (long)(sink.nextAttemptMs - now);
+    wait = min(wait, left > 0 ? (unsigned long)left : 0UL);
+  }
+  return wait == NOTIFY_NEVER ? portMAX_DELAY : pdMS_TO_TICKS(wait);
+}
+
+static void notifierTask(void* param) {
+  NotifyMessage msg;
+
+  for (;;) {
+    if (xQueueReceive(notifyQueue, &msg, idleTicks()) == pdTRUE) {
+      if (coalescer.post(msg, millis(), settings.notifyWindowS * 1000UL)) {
+        dispatch(msg);
+      } else {
+        coalescedCount++;
+      }
+    }
+    while (coalescer.due(millis(), msg)) {
+      dispatch(msg);
+    }
+    for (int i = 0; i < NOTIFY_SINK_COUNT; i++) {
+      serviceSink(sinks[i]);
+    }
+  }
+}
+
+static void initSink(NotifySinkId id, const char* name, bool enabled, const char* eventList, SinkPost post) {
+  Sink& sink = sinks[id];
+  sink.name = name;
+  sink.enabled = enabled;
+  sink.eventList = eventList;
+  sink.post = post;
+  sink.backoffMs = NOTIFY_BACKOFF_MS;
+}
+
+void notifierBegin() {
+  if (notifyQueue != NULL) return;
+
+  // Same trust model as the old per-message HTTPClient: no CA pinning
+  webhookClient.setInsecure();
+  webhookHttp.setReuse(true);
+  webhookHttp.collectHeaders(DISCORD_HEADERS, sizeof(DISCORD_HEADERS) / sizeof(DISCORD_HEADERS[0]));
+  ntfySecureClient.setInsecure();
+
+  initSink(NOTIFY_SINK_DISCORD, "discord", strlen(DISCORD_WEBHOOK_URL) > 0, settings.discordEvents, postDiscord);
+  initSink(NOTIFY_SINK_MQTT, "mqtt", mqttGetStats().enabled, settings.mqttEvents, postMqtt);
+  initSink(NOTIFY_SINK_NTFY, "ntfy", NTFY_ENABLED, settings.ntfyEvents, postNtfy);
+
+  queueProbe = perfRegister("notify_queue");
+  postProbe = perfRegister("notify_post");
+
+  notifyQueue = xQueueCreate(NOTIFY_QUEUE_LENGTH, sizeof(NotifyMessage));
+  xTaskCreatePinnedToCore(notifierTask, "notifier", NOTIFY_TASK_STACK, NULL,
+                          NOTIFY_TASK_PRIORITY, NULL, NOTIFY_TASK_CORE);
+}
+
+bool sendNotification(NotifyEvent event, const String& message) {
+  if (notifyQueue == NULL) return false;
+  PerfTimer timer(queueProbe);
+
+  NotifyMessage msg;
+  msg.event = event;
+  strlcpy(msg.text, message.c_str(), sizeof(msg.text));
+
+  // Drop the oldest message to make room; a fresh "OFF" beats a stale "ON"
+  while (xQueueSend(notifyQueue, &msg, 0) != pdTRUE) {
+    NotifyMessage oldest;
+    if (xQueueReceive(notifyQueue, &oldest, 0) == pdTRUE) {
+      droppedCount++;
+      Serial.println("Notification queue full, dropped oldest message.");
+    }
+  }
+  return true;
+}
+
+unsigned long notifierDroppedCount() {
+  return droppedCount;
+}
+
+unsigned long notifierCoalescedCount() {
+  return coalescedCount;
+}
+
+NotifierStats notifierGetStats(NotifySinkId id) {
+  const Sink& sink = sinks[id];
+  NotifierStats stats;
+  stats.enabled = sink.enabled;
+  stats.handshakes = sink.handshakes;
+  stats.sent = sink.sent;
+  stats.avgSendMs = sink.sent > 0 ? sink.totalSendMs / sink.sent : 0;
+  stats.dropped = sink.dropped;
+  stats.rateLimited = sink.rateLimited;
+  return stats;
+}
+
+const char* notifySinkName(NotifySinkId id) {
+  return sinks[id].name ? sinks[id].name : "?";
+}
@@ -0,0 +1,111 @@
+#include <string.h>
+#include <strings.h>
+#include <stdio.h>
+#include "notify_rules.h"
+
+static const char* const EVENT_NAMES[NOTIFY_EVENT_COUNT] = {
+  "on", "off", "reached", "left", "overtemp", "fault", "safety", "time", "tune", "sched"
+};
+
+const char* notifyEventName(NotifyEvent event) {
+  return event < NOTIFY_EVENT_COUNT ? EVENT_NAMES[event] : "?";
+}
+
+bool parseNotifyEvents(const char* text, uint32_t& mask) {
+  if (text[0] == '\0' || strcasecmp(text, "all") == 0) {
+    mask = NOTIFY_ALL_EVENTS;
+    return true;
+  }
+  if (strcasecmp(text, "none") == 0) {
+    mask = 0;
+    return true;
+  }
+
+  uint32_t parsed = 0;
+  const char* p = text;
+  while (*p) {
+    size_t len = strcspn(p, ",");
+    int event = -1;
+    for (int i = 0; i < NOTIFY_EVENT_COUNT; i++) {
+      if (strlen(EVENT_NAMES[i]) == len && strncasecmp(p, EVENT_NAMES[i], len) == 0) event = i;
+    }
+    if (event < 0) return false;
+    parsed |= 1UL << event;
+    p += len;
+    if (*p == ',') p++;
+  }
+  mask = parsed;
+  return true;
+}
+
+bool notifyUrgent(NotifyEvent event) {
+  return event == NOTIFY_OVER_TEMP || event == NOTIFY_SENSOR_FAULT || event == NOTIFY_SAFETY;
+}
+
+NotifyCoalescer::NotifyCoalescer() {
+  memset(slots, 0, sizeof(slots));
+}
+
+// On and off share a slot, so a quick on-off-on sends the outcome only
+int NotifyCoalescer::keyFor(NotifyEvent event) {
+  return event == NOTIFY_OFF ? NOTIFY_ON : event;
+}
+
+bool NotifyCoalescer::post(const NotifyMessage& msg, unsigned long nowMs, unsigned long windowMs) {
+  NotifyEvent event = (NotifyEvent)msg.event;
+  if (event >= NOTIFY_EVENT_COUNT || windowMs == 0 || notifyUrgent(event)) return true;
+
+  Slot& slot = slots[keyFor(event)];
+  if (!slot.open || (long)(nowMs - slot.windowEndMs) >= 0) {
+    // Quiet until now: this one goes straight out and opens a window
+    slot.open = true;
+    slot.pending = false;
+    slot.merged = 0;
+    slot.windowMs = windowMs;
+    slot.windowEndMs = nowMs + windowMs;
+    return true;
+  }
+
+  slot.latest = msg;
+  slot.pending = true;
+  slot.merged++;
+  return false;
+}
+
+bool NotifyCoalescer::due(unsigned long nowMs, NotifyMessage& out) {
+  for (int i = 0; i < NOTIFY_EVENT_COUNT; i++) {
+    Slot& slot = slots[i];
+    if (!slot.open || (long)(nowMs - slot.windowEndMs) < 0) continue;
+
+    if (!slot.pending) {
+      slot.open = false;   // Nothing more came in
+      continue;
+    }
+
+    out = slot.latest;
+    if (slot.merged > 1) {
+      size_t used = strlen(out.text);
+      snprintf(out.text + used, sizeof(out.text) - used, " (x%d)", slot.merged);
+    }
+
+    // The trailing message starts a fresh window, so a steady stream still
+    // comes out at most once per window
+    slot.pending = false;
+    slot.merged = 0;
+    slot.windowEndMs = nowMs + slot.windowMs;
+    return true;
+  }
+  return false;
+}
+
+unsigned long NotifyCoalescer::msUntilDue(unsigned long nowMs) const {
+  unsigned long soonest = NOTIFY_NEVER;
+  for (int i = 0; i < NOTIFY_EVENT_COUNT; i++) {
+    const Slot& slot = slots[i];
+    if (!slot.open) continue;
+    long left = (long)(slot.windowEndMs - nowMs);
+    unsigned long wait = left > 0 ? left : 0;
+    if (wait < soonest) soonest = wait;
+  }
+  return soonest;
+}
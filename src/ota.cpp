@@ -0,0 +1,198 @@
+#include <WiFi.h>
+#include <ArduinoOTA.h>
+#include <Update.h>
+#include <esp_ota_ops.h>
+#include <secrets.h>
+#include "ota.h"
+#include "safety.h"
+
+#ifdef OTA_PASSWORD
+#define OTA_ENABLED true
+#else
+#define OTA_ENABLED false
+#define OTA_PASSWORD ""
+#endif
+#ifndef OTA_USER
+#define OTA_USER "admin"
+#endif
+#ifndef OTA_HOSTNAME
+#define OTA_HOSTNAME "sauna"
+#endif
+
+// Who holds the Update singleton; the other path is turned away meanwhile
+enum OtaOwner {
+  OWNER_NONE,
+  OWNER_ARDUINO_OTA,
+  OWNER_HTTP
+};
+
+static void (*startCallback)() = NULL;
+static portMUX_TYPE otaMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile OtaOwner owner = OWNER_NONE;
+static AsyncWebServerRequest* volatile uploader = NULL;   // The request streaming the image
+static volatile unsigned long rebootAtMs = 0;
+static const char* lastError = "";
+
+// The rebooted-into image says whether it stays, in otaSelfTest().  This
+// arduino-esp32 hook stops the core from marking it good by itself.
+extern "C" bool verifyRollbackLater() {
+  return true;
+}
+
+// Takes ownership and holds the heater off for the rest of the update
+static bool claimUpdate(OtaOwner who) {
+  portENTER_CRITICAL(&otaMux);
+  bool claimed = owner == OWNER_NONE;
+  if (claimed) owner = who;
+  portEXIT_CRITICAL(&otaMux);
+  if (!claimed) return false;
+
+  safetyInhibit(true);
+  lastError = "";
+  Serial.printf("OTA: update started (%s), heater held off\n",
+                who == OWNER_HTTP ? "HTTP" : "ArduinoOTA");
+  if (startCallback) startCallback();
+  return true;
+}
+
+// A failed or abandoned update lets the heater run again
+static void releaseUpdate(OtaOwner who, const char* error) {
+  if (owner != who) return;
+  lastError = error;
+  Serial.printf("OTA: update failed, %s\n", error);
+  owner = OWNER_NONE;
+  safetyInhibit(false);
+}
+
+static void otaTask(void* param) {
+  // ArduinoOTA's listener needs the network stack up
+  while (WiFi.status() != WL_CONNECTED) {
+    vTaskDelay(pdMS_TO_TICKS(1000));
+  }
+
+  ArduinoOTA.setHostname(OTA_HOSTNAME);
+  ArduinoOTA.setPassword(OTA_PASSWORD);
+  ArduinoOTA.onStart([]() { claimUpdate(OWNER_ARDUINO_OTA); });
+  ArduinoOTA.onError([](ota_error_t error) { releaseUpdate(OWNER_ARDUINO_OTA, "ArduinoOTA error"); });
+  ArduinoOTA.begin();   // Reboots by itself once an image is complete
+  Serial.printf("OTA: listening as %s.local\n", OTA_HOSTNAME);
+
+  for (;;) {
+    ArduinoOTA.handle();
+    if (rebootAtMs != 0 && (long)(millis() - rebootAtMs) >= 0) {
+      Serial.println("OTA: rebooting into the new image");
+      ESP.restart();
+    }
+    vTaskDelay(pdMS_TO_TICKS(OTA_POLL_MS));
+  }
+}
+
+void otaBegin(void (*onStart)()) {
+  if (!OTA_ENABLED) return;
+  startCallback = onStart;
+  xTaskCreatePinnedToCore(otaTask, "ota", OTA_TASK_STACK, NULL,
+                          OTA_TASK_PRIORITY, NULL, OTA_TASK_CORE);
+}
+
+void otaHandleUpload(AsyncWebServerRequest* request, const String& filename, size_t index,
+                     uint8_t* data, size_t len, bool final) {
+  if (!OTA_ENABLED) return;
+
+  if (index == 0) {
+    if (!request->authenticate(OTA_USER, OTA_PASSWORD)) return;
+    if (!claimUpdate(OWNER_HTTP)) return;   // The reply says it was busy
+    uploader = request;
+
+    // The connection dropping mid-image must not leave the heater held off
+    request->onDisconnect([request]() {
+      if (uploader != request) return;
+      uploader = NULL;
+      Update.abort();
+      releaseUpdate(OWNER_HTTP, "upload interrupted");
+    });
+
+    // Unknown size: the whole inactive partition is available
+    if (!Update.begin(UPDATE_SIZE_UNKNOWN, U_FLASH)) {
+      uploader = NULL;
+      releaseUpdate(OWNER_HTTP, Update.errorString());
+      return;
+    }
+  }
+  if (uploader != request) return;
+
+  // Straight to flash; nothing beyond the current chunk is held in RAM
+  if (Update.write(data, len) != len) {
+    uploader = NULL;
+    Update.abort();
+    releaseUpdate(OWNER_HTTP, Update.errorString());
+    return;
+  }
+  if (final && !Update.end(true)) {
+    uploader = NULL;
+    releaseUpdate(OWNER_HTTP, Update.errorString());
+  }
+}
+
+void otaHandleUpdateDone(AsyncWebServerRequest* request) {
+  if (!OTA_ENABLED) {
+    request->send(404, "text/plain", "Updates are disabled (no OTA_PASSWORD)");
+    return;
+  }
+  if (!request->authenticate(OTA_USER, OTA_PASSWORD)) {
+    request->requestAuthentication();
+    return;
+  }
+
+  if (uploader != request) {
+    // Never started, or failed part way; lastError says why
+    request->send(owner == OWNER_NONE ? 500 : 409, "text/plain",
+                  owner == OWNER_NONE ? String("Update failed: ") + lastError
+                                      : String("Another update is in progress"));
+    return;
+  }
+
+  uploader = NULL;
+  if (!Update.isFinished()) {
+    Update.abort();
+    releaseUpdate(OWNER_HTTP, "image incomplete");
+    request->send(500, "text/plain", "Update failed: image incomplete");
+    return;
+  }
+  request->send(200, "text/plain", "Update written, rebooting");
+  rebootAtMs = millis() + OTA_REBOOT_DELAY_MS;   // The heater stays held off until then
+}
+
+bool otaSelfTest(bool sensorPresent) {
+  const esp_partition_t* running = esp_ota_get_running_partition();
+  esp_ota_img_states_t state;
+  if (esp_ota_get_state_partition(running, &state) != ESP_OK ||
+      state != ESP_OTA_IMG_PENDING_VERIFY) {
+    return true;   // Not on probation (USB flash, or already confirmed)
+  }
+
+  unsigned long start = millis();
+  while (!safetyRunning() && millis() - start < OTA_SELF_TEST_WAIT_MS) {
+    delay(10);
+  }
+  bool supervisorRunning = safetyRunning();
+
+  if (sensorPresent && supervisorRunning) {
+    esp_ota_mark_app_valid_cancel_rollback();
+    Serial.println("OTA: self-test passed, new image kept");
+    return true;
+  }
+
+  Serial.printf("OTA: self-test failed (sensor %s, supervisor %s), rolling back\n",
+                sensorPresent ? "ok" : "missing", supervisorRunning ? "ok" : "not running");
+  esp_ota_mark_app_invalid_rollback_and_reboot();
+  return false;   // Only reached if there is no previous image to go back to
+}
+
+OtaStats otaGetStats() {
+  OtaStats stats;
+  stats.enabled = OTA_ENABLED;
+  stats.inProgress = owner != OWNER_NONE;
+  stats.partition = esp_ota_get_running_partition()->label;
+  stats.lastError = lastError;
+  return stats;
+}
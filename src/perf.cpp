@@ -0,0 +1,70 @@
+#include "perf.h"
+
+static PerfStats probes[PERF_MAX_PROBES];
+static int probeCount = 0;
+static portMUX_TYPE perfLock = portMUX_INITIALIZER_UNLOCKED;
+
+int perfRegister(const char* name) {
+  int id = -1;
+  portENTER_CRITICAL(&perfLock);
+  if (probeCount < PERF_MAX_PROBES) {
+    id = probeCount++;
+    memset(&probes[id], 0, sizeof(probes[id]));
+    probes[id].name = name;
+    probes[id].minUs = UINT32_MAX;
+  }
+  portEXIT_CRITICAL(&perfLock);
+  return id;
+}
+
+// Index of the first power of two above us: 0 us -> 0, 1 us -> 1, 2-3 us -> 2...
+static int bucketFor(uint32_t us) {
+  int bucket = us == 0 ? 0 : 32 - __builtin_clz(us);
+  return bucket < PERF_BUCKETS ? bucket : PERF_BUCKETS - 1;
+}
+
+void perfRecordUs(int probe, uint32_t us) {
+  if (probe < 0 || probe >= PERF_MAX_PROBES) return;
+  int bucket = bucketFor(us);
+
+  portENTER_CRITICAL(&perfLock);
+  PerfStats& s = probes[probe];
+  s.count++;
+  s.sumUs += us;
+  if (us < s.minUs) s.minUs = us;
+  if (us > s.maxUs) s.maxUs = us;
+  s.buckets[bucket]++;
+  portEXIT_CRITICAL(&perfLock);
+}
+
+void perfRecordCycles(int probe, int core, uint32_t mhz, uint32_t cycles) {
+  if ((int)xPortGetCoreID() != core || getCpuFrequencyMhz() != mhz) return;
+  perfRecordUs(probe, cycles / mhz);
+}
+
+int perfProbeCount() {
+  return probeCount;
+}
+
+bool perfRead(int probe, PerfStats& out) {
+  if (probe < 0 || probe >= probeCount) return false;
+  portENTER_CRITICAL(&perfLock);
+  out = probes[probe];
+  portEXIT_CRITICAL(&perfLock);
+  return true;
+}
+
+uint32_t perfPercentileUs(const PerfStats& stats, float p) {
+  if (stats.count == 0) return 0;
+
+  uint32_t rank = (uint32_t)ceilf(stats.count * p);
+  uint32_t seen = 0;
+  for (int i = 0; i < PERF_BUCKETS - 1; i++) {
+    seen += stats.buckets[i];
+    if (seen >= rank) {
+      uint32_t upper = (1UL << i) - 1;   // Largest duration bucket i can hold
+      return min(upper, stats.maxUs);
+    }
+  }
+  return stats.maxUs;
+}
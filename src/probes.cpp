@@ -0,0 +1,137 @@
+#include <OneWire.h>
+#include "probes.h"
+
+static OneWire oneWire;
+static DallasTemperature sensors(&oneWire);
+
+static Probe probes[MAX_PROBES];
+static int count = 0;
+static int controlIndex = -1;     // The bench probe, -1 if none
+static uint8_t currentResolution = 12;
+
+int probesBegin(uint8_t pin, uint8_t resolution) {
+  oneWire.begin(pin);
+  sensors.begin();
+  sensors.setWaitForConversion(false);
+  // Resolution changes at runtime; keep them out of the probes' EEPROM
+  sensors.setAutoSaveScratchPad(false);
+  currentResolution = resolution;
+
+  count = 0;
+  DeviceAddress address;
+  oneWire.reset_search();
+  while (count < MAX_PROBES && oneWire.search(address)) {
+    if (!sensors.validAddress(address) || !sensors.validFamily(address)) continue;
+
+    // Insertion sort by ROM address keeps the listing stable across boots
+    int i = count++;
+    while (i > 0 && memcmp(probes[i - 1].address, address, sizeof(DeviceAddress)) > 0) {
+      probes[i] = probes[i - 1];
+      i--;
+    }
+    memcpy(probes[i].address, address, sizeof(DeviceAddress));
+  }
+
+  controlIndex = -1;
+  for (int i = 0; i < count; i++) {
+    strlcpy(probes[i].name, PROBE_UNASSIGNED_NAME, sizeof(probes[i].name));
+    probes[i].role = PROBE_UNASSIGNED;
+    probes[i].tempF = DEVICE_DISCONNECTED_F;
+    sensors.setResolution(probes[i].address, resolution);
+
+    char id[17];
+    formatProbeAddress(probes[i].address, id);
+    Serial.printf("Probe %d: %s\n", i, id);
+  }
+  if (count == 0) {
+    Serial.println("No temperature probes found.");
+  }
+  return count;
+}
+
+void probesAssignRoles(const char* const addresses[PROBE_ROLE_COUNT]) {
+  static const char* names[] = PROBE_NAMES;
+
+  controlIndex = -1;
+  for (int i = 0; i < count; i++) {
+    char id[17];
+    formatProbeAddress(probes[i].address, id);
+    probes[i].role = PROBE_UNASSIGNED;
+    for (int role = 0; role < PROBE_ROLE_COUNT; role++) {
+      if (strcasecmp(addresses[role], id) == 0) {
+        probes[i].role = (ProbeRole)role;
+        break;
+      }
+    }
+    strlcpy(probes[i].name, probes[i].role == PROBE_UNASSIGNED ? PROBE_UNASSIGNED_NAME
+                                                               : names[probes[i].role],
+            sizeof(probes[i].name));
+    if (probes[i].role == PROBE_BENCH) controlIndex = i;
+    Serial.printf("Probe %s: %s\n", id, probes[i].name);
+  }
+
+  // Nothing set for the bench yet (a new or upgraded unit): heat on the
+  // first probe that has no other role, as before roles existed.  A set
+  // address whose probe is missing stays missing rather than moving.
+  if (addresses[PROBE_BENCH][0] == '\0') {
+    for (int i = 0; i < count && controlIndex < 0; i++) {
+      if (probes[i].role != PROBE_UNASSIGNED) continue;
+      probes[i].role = PROBE_BENCH;
+      strlcpy(probes[i].name, names[PROBE_BENCH], sizeof(probes[i].name));
+      controlIndex = i;
+      Serial.printf("Probe %d: bench (default)\n", i);
+    }
+  }
+}
+
+bool probesHaveControl() {
+  return controlIndex >= 0;
+}
+
+int probeCount() {
+  return count;
+}
+
+const Probe& probe(int index) {
+  return probes[index];
+}
+
+void probesSetResolution(uint8_t resolution) {
+  if (resolution == currentResolution) return;
+  for (int i = 0; i < count; i++) {
+    sensors.setResolution(probes[i].address, resolution);
+  }
+  currentResolution = resolution;
+}
+
+uint8_t probesResolution() {
+  return currentResolution;
+}
+
+unsigned long probesConversionMs() {
+  return sensors.millisToWaitForConversion(currentResolution);
+}
+
+void probesRequest() {
+  sensors.requestTemperatures();   // Skip ROM: every probe converts at once
+}
+
+bool probesReady() {
+  return sensors.isConversionComplete();
+}
+
+void probesRead() {
+  for (int i = 0; i < count; i++) {
+    probes[i].tempF = sensors.getTempF(probes[i].address);
+  }
+}
+
+float controlTempF() {
+  return controlIndex >= 0 ? probes[controlIndex].tempF : DEVICE_DISCONNECTED_F;
+}
+
+void formatProbeAddress(const DeviceAddress address, char* buf) {
+  for (int i = 0; i < 8; i++) {
+    sprintf(buf + i * 2, "%02x", address[i]);
+  }
+}
@@ -0,0 +1,182 @@
+#include <esp_task_wdt.h>
+#include <esp_timer.h>
+#include <DallasTemperature.h>
+#include "safety.h"
+
+static uint8_t ssrPin = 0;
+static void (*tripCallback)() = NULL;
+static TaskHandle_t safetyTaskHandle = NULL;
+
+// The trip flag and the SSR pin change together under this, so a heater
+// request racing a trip can never leave the pin high
+static portMUX_TYPE safetyMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile SafetyTrip trip = SAFETY_OK;
+static volatile unsigned long tripCount = 0;
+static volatile bool inhibited = false;
+static volatile unsigned long lastTickMs = 0;
+
+// --- SSR conduction time, stamped at every pin change (under safetyMux) ---
+static bool ssrLevel = false;
+static int64_t ssrOnSinceUs = 0;
+static uint64_t ssrOnTotalUs = 0;
+
+// --- Reports from the control loop ---
+static volatile bool sessionActive = false;
+static volatile unsigned long sessionStartMs = 0;
+static volatile unsigned long lastValidTempMs = 0;
+static volatile float lastControlF = DEVICE_DISCONNECTED_F;
+static volatile float lastHottestF = DEVICE_DISCONNECTED_F;
+static volatile unsigned long lastLoopMs = 0;
+
+// Every write to the SSR pin goes through here, inside safetyMux, so the
+// on-time covers trips and inhibits as well as normal switching
+static void writeSsr(bool level) {
+  digitalWrite(ssrPin, level ? HIGH : LOW);
+  if (level == ssrLevel) return;
+  int64_t now = esp_timer_get_time();
+  if (level) {
+    ssrOnSinceUs = now;
+  } else {
+    ssrOnTotalUs += now - ssrOnSinceUs;
+  }
+  ssrLevel = level;
+}
+
+static void latchTrip(SafetyTrip reason) {
+  portENTER_CRITICAL(&safetyMux);
+  bool fresh = trip == SAFETY_OK;
+  trip = reason;
+  writeSsr(false);
+  portEXIT_CRITICAL(&safetyMux);
+
+  if (fresh) {
+    tripCount++;
+    Serial.printf("SAFETY: heater cut, %s\n", safetyTripName(reason));
+    if (tripCallback) tripCallback();
+  }
+}
+
+// The first limit currently exceeded, or SAFETY_OK
+static SafetyTrip checkLimits(unsigned long now) {
+  float control = lastControlF;
+  float hottest = lastHottestF;
+  if (control != DEVICE_DISCONNECTED_F && control >= SAFETY_MAX_TEMP_F) return SAFETY_OVER_TEMP;
+  if (hottest != DEVICE_DISCONNECTED_F && hottest >= SAFETY_MAX_PROBE_F) return SAFETY_OVER_TEMP;
+
+  // The rest only matter while the heater may be asked to run
+  if (!sessionActive) return SAFETY_OK;
+  if (now - lastValidTempMs >= SAFETY_SENSOR_TIMEOUT_MS) return SAFETY_SENSOR_TIMEOUT;
+  if (now - sessionStartMs >= SAFETY_MAX_SESSION_MS) return SAFETY_MAX_ON_TIME;
+  if (now - lastLoopMs >= SAFETY_LOOP_STALL_MS) return SAFETY_LOOP_STALLED;
+  return SAFETY_OK;
+}
+
+static void safetyTask(void* param) {
+  esp_task_wdt_add(NULL);
+  TickType_t lastWake = xTaskGetTickCount();
+
+  for (;;) {
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SAFETY_PERIOD_MS));
+    esp_task_wdt_reset();
+
+    unsigned long now = millis();
+    lastTickMs = now;
+    SafetyTrip reason = checkLimits(now);
+    if (reason != SAFETY_OK) {
+      latchTrip(reason);
+    } else if (trip != SAFETY_OK && !sessionActive) {
+      trip = SAFETY_OK;   // Session over and the cause is gone
+      Serial.println("SAFETY: cleared");
+    }
+
+    // Belt and braces: nothing may have raised the pin behind our back
+    if (trip != SAFETY_OK || inhibited) {
+      portENTER_CRITICAL(&safetyMux);
+      writeSsr(false);
+      portEXIT_CRITICAL(&safetyMux);
+    }
+  }
+}
+
+void safetyBegin(uint8_t pin, void (*onTrip)()) {
+  if (safetyTaskHandle != NULL) return;
+  ssrPin = pin;
+  tripCallback = onTrip;
+  digitalWrite(ssrPin, LOW);
+  pinMode(ssrPin, OUTPUT);
+
+  lastLoopMs = millis();
+  lastValidTempMs = millis();
+
+  // The core has already started the TWDT for the idle tasks; this only
+  // sets our timeout and makes a stall reboot rather than just log
+  esp_task_wdt_init(SAFETY_WDT_TIMEOUT_S, true);
+  xTaskCreatePinnedToCore(safetyTask, "safety", SAFETY_TASK_STACK, NULL,
+                          SAFETY_TASK_PRIORITY, &safetyTaskHandle, SAFETY_TASK_CORE);
+}
+
+bool safetySetHeater(bool on) {
+  portENTER_CRITICAL(&safetyMux);
+  bool level = on && trip == SAFETY_OK && !inhibited;
+  writeSsr(level);
+  portEXIT_CRITICAL(&safetyMux);
+  return level;
+}
+
+void safetySetSession(bool active) {
+  if (active && !sessionActive) {
+    sessionStartMs = millis();
+    lastLoopMs = millis();
+    // The sensor timeout counts from the start: idle, the last reading
+    // may be a minute old, and loop() has a fresh one on the way
+    lastValidTempMs = millis();
+  }
+  sessionActive = active;
+}
+
+void safetyReportTemps(float controlF, float hottestF) {
+  lastControlF = controlF;
+  lastHottestF = hottestF;
+  if (controlF != DEVICE_DISCONNECTED_F) lastValidTempMs = millis();
+}
+
+void safetyLoopAlive() {
+  lastLoopMs = millis();
+}
+
+void safetyInhibit(bool inhibit) {
+  portENTER_CRITICAL(&safetyMux);
+  inhibited = inhibit;
+  if (inhibit) writeSsr(false);
+  portEXIT_CRITICAL(&safetyMux);
+}
+
+uint64_t safetyHeaterOnUs() {
+  portENTER_CRITICAL(&safetyMux);
+  uint64_t total = ssrOnTotalUs;
+  if (ssrLevel) total += esp_timer_get_time() - ssrOnSinceUs;
+  portEXIT_CRITICAL(&safetyMux);
+  return total;
+}
+
+bool safetyRunning() {
+  return safetyTaskHandle != NULL && millis() - lastTickMs < 5 * SAFETY_PERIOD_MS;
+}
+
+SafetyTrip safetyTripped() {
+  return trip;
+}
+
+unsigned long safetyTripCount() {
+  return tripCount;
+}
+
+const char* safetyTripName(SafetyTrip t) {
+  switch (t) {
+    case SAFETY_OVER_TEMP: return "over-temp";
+    case SAFETY_SENSOR_TIMEOUT: return "sensor timeout";
+    case SAFETY_MAX_ON_TIME: return "max on-time";
+    case SAFETY_LOOP_STALLED: return "loop stalled";
+    default: return "none";
+  }
+}
@@ -0,0 +1,16 @@
+#include "sample_profile.h"
+
+static bool sameProfile(const SampleProfile& a, const SampleProfile& b) {
+  return a.resolution == b.resolution && a.periodMs == b.periodMs;
+}
+
+SampleProfile chooseSampleProfile(const SampleProfile& current, bool sessionActive,
+                                  float tempF, float setpointF) {
+  if (!sessionActive) return SAMPLE_IDLE;
+
+  float below = setpointF - tempF;
+  bool holding = sameProfile(current, SAMPLE_HOLDING);
+  float band = holding ? SAMPLE_LEAVE_BAND_F : SAMPLE_NEAR_BAND_F;
+
+  return below <= band ? SAMPLE_HOLDING : SAMPLE_HEATING;
+}
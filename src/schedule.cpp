@@ -0,0 +1,122 @@
+#include <string.h>
+#include <stdio.h>
+#include <strings.h>
+#include "schedule.h"
+
+static const char* DAY_NAMES[7] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+
+Scheduler::Scheduler() {
+  clear();
+}
+
+void Scheduler::clear() {
+  memset(entries, 0, sizeof(entries));
+}
+
+int Scheduler::add(const ScheduleEntry& entry) {
+  bool weekly = entry.weekdays != 0;
+  if (weekly ? entry.minuteOfDay >= 24 * 60 : entry.onceEpoch == 0) return -1;
+  if (entry.durationMin == 0) return -1;
+
+  for (int id = 0; id < SCHEDULE_MAX_ENTRIES; id++) {
+    if (entries[id].used) continue;
+    entries[id] = entry;
+    entries[id].used = true;
+    entries[id].weekdays &= 0x7F;
+    entries[id].lastFiredEpoch = 0;
+    return id;
+  }
+  return -1;
+}
+
+bool Scheduler::remove(int id) {
+  if (id < 0 || id >= SCHEDULE_MAX_ENTRIES || !entries[id].used) return false;
+  memset(&entries[id], 0, sizeof(entries[id]));
+  return true;
+}
+
+time_t Scheduler::nextStart(int id, time_t now) const {
+  const ScheduleEntry& e = entries[id];
+  if (!e.used) return 0;
+
+  // Anything a little in the past still counts, so a late check (or a
+  // reboot just before) doesn't skip it
+  time_t earliest = now - SCHEDULE_MISSED_GRACE_S;
+
+  if (e.weekdays == 0) {
+    return (time_t)e.onceEpoch >= earliest ? (time_t)e.onceEpoch : 0;
+  }
+
+  struct tm today;
+  localtime_r(&now, &today);
+  for (int day = -1; day <= 7; day++) {
+    struct tm t = today;
+    t.tm_mday += day;
+    t.tm_hour = e.minuteOfDay / 60;
+    t.tm_min = e.minuteOfDay % 60;
+    t.tm_sec = 0;
+    t.tm_isdst = -1;          // Let mktime work out DST for that day
+    time_t start = mktime(&t);
+    if (start < earliest || start <= (time_t)e.lastFiredEpoch) continue;
+
+    struct tm check;
+    localtime_r(&start, &check);
+    if (e.weekdays & (1 << check.tm_wday)) return start;
+  }
+  return 0;
+}
+
+void Scheduler::markFired(int id, time_t start) {
+  if (entries[id].weekdays == 0) {
+    remove(id);
+  } else {
+    entries[id].lastFiredEpoch = start;
+  }
+}
+
+time_t Scheduler::soonest(time_t now, int* idOut) const {
+  time_t best = 0;
+  for (int id = 0; id < SCHEDULE_MAX_ENTRIES; id++) {
+    time_t start = nextStart(id, now);
+    if (start != 0 && (best == 0 || start < best)) {
+      best = start;
+      if (idOut) *idOut = id;
+    }
+  }
+  return best;
+}
+
+uint8_t parseWeekdays(const char* text) {
+  if (strcasecmp(text, "daily") == 0) return 0x7F;
+  if (strcasecmp(text, "weekdays") == 0) return 0x3E;
+  if (strcasecmp(text, "weekends") == 0) return 0x41;
+
+  uint8_t mask = 0;
+  const char* p = text;
+  while (*p) {
+    int day = -1;
+    for (int i = 0; i < 7; i++) {
+      if (strncasecmp(p, DAY_NAMES[i], 3) == 0) day = i;
+    }
+    if (day < 0) return 0;
+    mask |= 1 << day;
+    p += 3;
+    if (*p == ',') p++;
+    else if (*p) return 0;
+  }
+  return mask;
+}
+
+void formatWeekdays(uint8_t mask, char* buf, size_t len) {
+  if (len == 0) return;
+  buf[0] = '\0';
+  if ((mask & 0x7F) == 0x7F) {
+    snprintf(buf, len, "Daily");
+    return;
+  }
+  for (int i = 0; i < 7; i++) {
+    if (!(mask & (1 << i))) continue;
+    size_t used = strlen(buf);
+    snprintf(buf + used, len - used, "%s%s", used > 0 ? "," : "", DAY_NAMES[i]);
+  }
+}
@@ -0,0 +1,27 @@
+#include <Preferences.h>
+#include "schedule_store.h"
+
+#define SCHEDULE_NAMESPACE "schedule"
+
+bool loadSchedule(Scheduler& scheduler) {
+  Preferences prefs;
+  if (!prefs.begin(SCHEDULE_NAMESPACE, true)) return false;   // Read-only
+
+  size_t size = sizeof(ScheduleEntry) * Scheduler::SIZE;
+  bool found = prefs.isKey("entries") && prefs.getBytesLength("entries") == size;
+  if (found) {
+    prefs.getBytes("entries", scheduler.data(), size);
+  }
+  prefs.end();
+  return found;
+}
+
+void saveSchedule(Scheduler& scheduler) {
+  Preferences prefs;
+  if (!prefs.begin(SCHEDULE_NAMESPACE, false)) {
+    Serial.println("Could not open NVS to save the schedule.");
+    return;
+  }
+  prefs.putBytes("entries", scheduler.data(), sizeof(ScheduleEntry) * Scheduler::SIZE);
+  prefs.end();
+}
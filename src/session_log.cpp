@@ -0,0 +1,239 @@
+#include <LittleFS.h>
+#include "session_log.h"
+
+#define SESSION_TASK_STACK 4096
+#define SESSION_TASK_PRIORITY 1
+#define SESSION_TASK_CORE 0
+
+enum LogMessageType : uint8_t {
+  LOG_APPEND,
+  LOG_PAGE
+};
+
+// One request to the log task
+struct LogMessage {
+  LogMessageType type;
+  uint32_t seq;            // LOG_PAGE: echoed in the reply
+  uint32_t skip;           // LOG_PAGE: newest records to pass over
+  uint32_t max;            // LOG_PAGE: at most SESSION_PAGE_MAX
+  SessionRecord record;    // LOG_APPEND
+};
+
+struct LogReply {
+  uint32_t seq;
+  uint32_t total;
+  uint32_t count;
+  SessionRecord records[SESSION_PAGE_MAX];
+};
+
+static QueueHandle_t logQueue = NULL;
+static QueueHandle_t replyQueue = NULL;
+static SemaphoreHandle_t readerMutex = NULL;   // One reader at a time; never held by the log task
+static uint32_t readerSeq = 0;
+static LogReply readerReply;                   // Under readerMutex; too big for a caller's stack
+
+// --- Owned by the log task ---
+static bool mounted = false;
+
+// Record counts in the two files, kept in RAM so paging never stats them
+static uint32_t oldCount = 0;
+static uint32_t fileCount = 0;
+
+static SessionRecord pending[SESSION_PENDING_MAX];
+static int pendingCount = 0;
+static unsigned long oldestPendingMs = 0;
+static LogReply pageReply;     // Built here, then copied into the reply queue
+
+static uint16_t crc16(const uint8_t* data, size_t len) {
+  uint16_t crc = 0xFFFF;
+  while (len--) {
+    crc ^= (uint16_t)(*data++) << 8;
+    for (int i = 0; i < 8; i++) {
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+static bool recordValid(const SessionRecord& record) {
+  return record.magic == SESSION_RECORD_MAGIC &&
+         record.crc == crc16((const uint8_t*)&record, offsetof(SessionRecord, crc));
+}
+
+static uint32_t recordsIn(const char* path) {
+  if (!LittleFS.exists(path)) return 0;
+  File f = LittleFS.open(path, "r");
+  if (!f) return 0;
+  uint32_t n = f.size() / sizeof(SessionRecord);   // A torn tail is padded on the next flush
+  f.close();
+  return n;
+}
+
+// Writes everything pending in one append
+static void flushPending() {
+  if (pendingCount == 0 || !mounted) return;
+
+  if ((fileCount + pendingCount) * sizeof(SessionRecord) > SESSION_LOG_MAX_BYTES) {
+    LittleFS.remove(SESSION_LOG_OLD_FILE);
+    LittleFS.rename(SESSION_LOG_FILE, SESSION_LOG_OLD_FILE);
+    oldCount = fileCount;
+    fileCount = 0;
+  }
+
+  File f = LittleFS.open(SESSION_LOG_FILE, "a");
+  if (!f) {
+    Serial.println("Could not open session log for append.");
+    return;   // Keep them pending and try again next time
+  }
+
+  // A torn tail from an earlier power cut would misalign everything after
+  // it.  Pad it out to a whole record; its CRC fails and readers skip it.
+  size_t torn = f.size() % sizeof(SessionRecord);
+  if (torn != 0) {
+    uint8_t zeros[sizeof(SessionRecord)] = {0};
+    f.write(zeros, sizeof(SessionRecord) - torn);
+    fileCount = f.size() / sizeof(SessionRecord);
+  }
+
+  size_t bytes = pendingCount * sizeof(SessionRecord);
+  if (f.write((const uint8_t*)pending, bytes) == bytes) {
+    fileCount += pendingCount;
+    pendingCount = 0;
+  }
+  f.close();
+}
+
+static void addPending(const SessionRecord& record) {
+  if (pendingCount >= SESSION_PENDING_MAX) {
+    // Flash has been failing; lose the oldest rather than grow
+    memmove(pending, pending + 1, (SESSION_PENDING_MAX - 1) * sizeof(SessionRecord));
+    pendingCount--;
+  }
+  if (pendingCount == 0) oldestPendingMs = millis();
+  pending[pendingCount++] = record;
+  if (pendingCount >= SESSION_PENDING_MAX) flushPending();
+}
+
+static bool readRecord(uint32_t index, SessionRecord& record) {
+  if (index < oldCount + fileCount) {
+    const char* path = index < oldCount ? SESSION_LOG_OLD_FILE : SESSION_LOG_FILE;
+    uint32_t offset = index < oldCount ? index : index - oldCount;
+    bool ok = false;
+    File f = LittleFS.open(path, "r");
+    if (f && f.seek(offset * sizeof(SessionRecord))) {
+      ok = f.read((uint8_t*)&record, sizeof(record)) == sizeof(record);
+    }
+    if (f) f.close();
+    return ok;
+  }
+  if (index < oldCount + fileCount + pendingCount) {
+    record = pending[index - oldCount - fileCount];
+    return true;
+  }
+  return false;
+}
+
+// Fills reply with the page below the skip newest records, newest first.
+// The whole page is read in one go, so a rotation can't shift it midway.
+static void readPage(uint32_t skip, uint32_t max, LogReply& reply) {
+  reply.total = oldCount + fileCount + pendingCount;
+  reply.count = 0;
+  uint32_t next = skip < reply.total ? reply.total - skip : 0;   // One past the record to read
+  uint32_t stop = next > max ? next - max : 0;
+  for (; next > stop; next--) {
+    SessionRecord& record = reply.records[reply.count];
+    if (readRecord(next - 1, record) && recordValid(record)) reply.count++;   // Torn or corrupt: left out
+  }
+}
+
+// Time until the oldest pending record is due out, or forever with none
+static TickType_t flushWait() {
+  if (pendingCount == 0) return portMAX_DELAY;
+  unsigned long age = millis() - oldestPendingMs;
+  return age >= SESSION_FLUSH_MS ? 0 : pdMS_TO_TICKS(SESSION_FLUSH_MS - age);
+}
+
+static void logTask(void* param) {
+  mounted = LittleFS.begin(true);   // Format on first boot
+  if (!mounted) {
+    Serial.println("LittleFS mount failed; sessions will not be saved.");
+  } else {
+    oldCount = recordsIn(SESSION_LOG_OLD_FILE);
+    fileCount = recordsIn(SESSION_LOG_FILE);
+    Serial.printf("Session log: %lu records\n", (unsigned long)(oldCount + fileCount));
+  }
+
+  for (;;) {
+    LogMessage msg;
+    if (xQueueReceive(logQueue, &msg, flushWait()) != pdTRUE) {
+      flushPending();   // The oldest has waited SESSION_FLUSH_MS
+      continue;
+    }
+
+    if (msg.type == LOG_APPEND) {
+      addPending(msg.record);
+      continue;
+    }
+
+    pageReply.seq = msg.seq;
+    readPage(msg.skip, msg.max, pageReply);
+    xQueueOverwrite(replyQueue, &pageReply);   // A stale reply nobody took is replaced
+  }
+}
+
+void sessionLogBegin() {
+  if (logQueue != NULL) return;
+  logQueue = xQueueCreate(SESSION_QUEUE_LENGTH, sizeof(LogMessage));
+  replyQueue = xQueueCreate(1, sizeof(LogReply));
+  readerMutex = xSemaphoreCreateMutex();
+
+  // The task mounts the filesystem itself, since nothing else may touch it
+  xTaskCreatePinnedToCore(logTask, "sessionlog", SESSION_TASK_STACK, NULL,
+                          SESSION_TASK_PRIORITY, NULL, SESSION_TASK_CORE);
+}
+
+void sessionLogAppend(SessionRecord record) {
+  if (logQueue == NULL) return;
+
+  LogMessage msg;
+  msg.type = LOG_APPEND;
+  msg.record = record;
+  msg.record.magic = SESSION_RECORD_MAGIC;
+  msg.record.version = SESSION_RECORD_VERSION;
+  memset(msg.record.reserved, 0, sizeof(msg.record.reserved));
+  msg.record.crc = crc16((const uint8_t*)&msg.record, offsetof(SessionRecord, crc));
+
+  if (xQueueSend(logQueue, &msg, 0) != pdTRUE) {
+    Serial.println("Session log queue full; session not saved.");
+  }
+}
+
+// Sends a page read to the log task and waits for its answer.  Replies
+// carry the request's sequence number, so one that arrives after its reader
+// gave up is recognised and skipped by the next.
+int sessionLogReadPage(uint32_t skip, uint32_t max, SessionRecord* out, uint32_t& total) {
+  if (logQueue == NULL) return -1;
+  TickType_t timeout = pdMS_TO_TICKS(SESSION_READ_TIMEOUT_MS);
+  if (xSemaphoreTake(readerMutex, timeout) != pdTRUE) return -1;
+
+  LogMessage msg;
+  msg.type = LOG_PAGE;
+  msg.seq = ++readerSeq;
+  msg.skip = skip;
+  msg.max = min(max, (uint32_t)SESSION_PAGE_MAX);
+  int count = -1;
+  if (xQueueSend(logQueue, &msg, timeout) == pdTRUE) {
+    TickType_t start = xTaskGetTickCount();
+    while (xTaskGetTickCount() - start < timeout) {
+      if (xQueueReceive(replyQueue, &readerReply, timeout - (xTaskGetTickCount() - start)) != pdTRUE) break;
+      if (readerReply.seq == msg.seq) {
+        total = readerReply.total;
+        count = readerReply.count;
+        memcpy(out, readerReply.records, count * sizeof(SessionRecord));
+        break;
+      }
+    }
+  }
+  xSemaphoreGive(readerMutex);
+  return count;
+}
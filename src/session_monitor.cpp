@@ -0,0 +1,29 @@
+#include "session_monitor.h"
+
+uint32_t SessionMonitor::update(bool saunaOn, float tempF, float setpointF,
+                                unsigned long remainingMs, unsigned long warnMs) {
+  uint32_t events = 0;
+
+  if (saunaOn != lastOn) {
+    events |= saunaOn ? SESSION_EVENT_ON : SESSION_EVENT_OFF;
+    if (saunaOn) {
+      reachedSent = false;
+      // A session shorter than the warning isn't warned about at once
+      warningSent = remainingMs <= warnMs;
+    }
+    lastOn = saunaOn;
+  }
+
+  if (saunaOn && !reachedSent && tempF >= setpointF) {
+    events |= SESSION_EVENT_REACHED;
+    reachedSent = true;
+  }
+
+  if (remainingMs > warnMs) {
+    warningSent = false;
+  } else if (saunaOn && warnMs > 0 && !warningSent) {
+    events |= SESSION_EVENT_MINUTES_LEFT;
+    warningSent = true;
+  }
+  return events;
+}
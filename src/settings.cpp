@@ -0,0 +1,176 @@
+#include <Preferences.h>
+#include "settings.h"
+#include "notify_rules.h"
+
+#define SETTINGS_NAMESPACE "settings"
+
+Settings settings;
+
+// Guards text fields while they're copied, so a reader on another task
+// never sees half an edit.  Held for a strlcpy only, never across NVS.
+static portMUX_TYPE textMux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool validEvents(const char* text) {
+  uint32_t mask;
+  return parseNotifyEvents(text, mask);
+}
+
+static bool validAddress(const char* text) {
+  if (text[0] == '\0') return true;   // Unassigned
+  if (strlen(text) != SETTING_ADDR_LEN - 1) return false;
+  for (const char* p = text; *p; p++) {
+    if (!isxdigit((unsigned char)*p)) return false;
+  }
+  return true;
+}
+
+#define FIELD(name) offsetof(Settings, name), sizeof(((Settings*)0)->name)
+
+static const SettingDef SETTING_DEFS[] = {
+  // key         label            type           field                 min    max    step  default unit   flags  validate
+  { "maxTime",   "Max time",      SETTING_INT,   FIELD(maxTimeMin),    10,    120,   5,    90,     "min", SETTING_MENU },
+  { "onTime",    "On time",       SETTING_INT,   FIELD(onTimeMin),     5,     120,   5,    90,     "min", SETTING_MENU },
+  { "addTime",   "Add time",      SETTING_INT,   FIELD(addTimeMin),    1,     60,    1,    15,     "min", SETTING_MENU },
+  { "setpoint",  "Boot setpoint", SETTING_FLOAT, FIELD(setpointF),     SETPOINT_MIN_F, SETPOINT_MAX_F, 1, 125, "F", SETTING_MENU },
+  { "maxRes",    "Resolution",    SETTING_INT,   FIELD(maxResolution), 9,     12,    1,    12,     "bit", SETTING_MENU },
+  { "ssid1",     "WiFi 1",        SETTING_TEXT,  FIELD(wifiSsid1),     0,     0,     0,    0,      "",    0 },
+  { "pwd1",      "WiFi 1 pass",   SETTING_TEXT,  FIELD(wifiPwd1),      0,     0,     0,    0,      "",    SETTING_SECRET },
+  { "ssid2",     "WiFi 2",        SETTING_TEXT,  FIELD(wifiSsid2),     0,     0,     0,    0,      "",    0 },
+  { "pwd2",      "WiFi 2 pass",   SETTING_TEXT,  FIELD(wifiPwd2),      0,     0,     0,    0,      "",    SETTING_SECRET },
+  { "warnAt",    "Warn at",       SETTING_INT,   FIELD(notifyLeftMin), 0,     60,    1,    10,     "min", SETTING_MENU },
+  { "coalesce",  "Coalesce",      SETTING_INT,   FIELD(notifyWindowS), 0,     600,   10,   30,     "s",   0 },
+  { "discordEv", "Discord events", SETTING_TEXT, FIELD(discordEvents), 0,     0,     0,    0,      "",    0, validEvents },
+  { "mqttEv",    "MQTT events",   SETTING_TEXT,  FIELD(mqttEvents),    0,     0,     0,    0,      "",    0, validEvents },
+  { "ntfyEv",    "ntfy events",   SETTING_TEXT,  FIELD(ntfyEvents),    0,     0,     0,    0,      "",    0, validEvents },
+  { "heaterW",   "Heater power",  SETTING_INT,   FIELD(heaterWatts),   500,   15000, 100,  6000,   "W",   0 },
+  { "idleMin",   "Idle after",    SETTING_INT,   FIELD(idleMin),       0,     60,    1,    5,      "min", SETTING_MENU },
+  { "probeBench", "Bench probe",  SETTING_TEXT,  FIELD(probeBench),    0,     0,     0,    0,      "",    0, validAddress },
+  { "probeCeil", "Ceiling probe", SETTING_TEXT,  FIELD(probeCeiling),  0,     0,     0,    0,      "",    0, validAddress },
+  { "probeHeat", "Heater probe",  SETTING_TEXT,  FIELD(probeHeater),   0,     0,     0,    0,      "",    0, validAddress },
+  { "probeAux",  "Aux probe",     SETTING_TEXT,  FIELD(probeAux),      0,     0,     0,    0,      "",    0, validAddress },
+};
+static const int SETTING_COUNT = sizeof(SETTING_DEFS) / sizeof(SETTING_DEFS[0]);
+
+static void* fieldOf(const SettingDef& def) {
+  return (uint8_t*)&settings + def.offset;
+}
+
+static void setNumber(const SettingDef& def, float value) {
+  if (def.type == SETTING_INT) {
+    *(int32_t*)fieldOf(def) = lroundf(value);
+  } else {
+    *(float*)fieldOf(def) = value;
+  }
+}
+
+void settingsBegin() {
+  for (int i = 0; i < SETTING_COUNT; i++) {
+    const SettingDef& def = SETTING_DEFS[i];
+    if (def.type == SETTING_TEXT) {
+      ((char*)fieldOf(def))[0] = '\0';
+    } else {
+      setNumber(def, def.defaultNumber);
+    }
+  }
+
+  Preferences prefs;
+  if (!prefs.begin(SETTINGS_NAMESPACE, true)) return;   // Nothing saved yet
+  for (int i = 0; i < SETTING_COUNT; i++) {
+    const SettingDef& def = SETTING_DEFS[i];
+    if (!prefs.isKey(def.key)) continue;
+    if (def.type == SETTING_TEXT) {
+      prefs.getString(def.key, (char*)fieldOf(def), def.size);
+    } else {
+      // Stored values are re-checked, so a narrowed range can't be escaped
+      float value = def.type == SETTING_INT ? prefs.getInt(def.key) : prefs.getFloat(def.key);
+      setNumber(def, constrain(value, def.min, def.max));
+    }
+  }
+  prefs.end();
+}
+
+int settingCount() {
+  return SETTING_COUNT;
+}
+
+const SettingDef& settingDef(int index) {
+  return SETTING_DEFS[index];
+}
+
+int settingFind(const char* key) {
+  for (int i = 0; i < SETTING_COUNT; i++) {
+    if (strcmp(SETTING_DEFS[i].key, key) == 0) return i;
+  }
+  return -1;
+}
+
+float settingNumber(int index) {
+  const SettingDef& def = SETTING_DEFS[index];
+  if (def.type == SETTING_INT) return *(int32_t*)fieldOf(def);
+  if (def.type == SETTING_FLOAT) return *(float*)fieldOf(def);
+  return 0;
+}
+
+bool settingValid(int index, const char* text) {
+  if (index < 0 || index >= SETTING_COUNT) return false;
+  const SettingDef& def = SETTING_DEFS[index];
+
+  if (def.type == SETTING_TEXT) {
+    return strlen(text) < def.size && (!def.validate || def.validate(text));
+  }
+
+  char* end;
+  float value = strtof(text, &end);
+  if (end == text || *end != '\0' || value < def.min || value > def.max) return false;
+  return def.type != SETTING_INT || value == floorf(value);
+}
+
+bool settingSet(int index, const char* text) {
+  if (!settingValid(index, text)) return false;
+  const SettingDef& def = SETTING_DEFS[index];
+
+  Preferences prefs;
+  if (!prefs.begin(SETTINGS_NAMESPACE, false)) return false;
+  if (def.type == SETTING_TEXT) {
+    prefs.putString(def.key, text);
+    prefs.end();
+    portENTER_CRITICAL(&textMux);
+    strlcpy((char*)fieldOf(def), text, def.size);
+    portEXIT_CRITICAL(&textMux);
+    return true;
+  }
+
+  float value = strtof(text, NULL);
+  if (def.type == SETTING_INT) {
+    prefs.putInt(def.key, lroundf(value));
+  } else {
+    prefs.putFloat(def.key, value);
+  }
+  prefs.end();
+  setNumber(def, value);
+  return true;
+}
+
+void settingFormat(int index, char* buf, size_t len) {
+  const SettingDef& def = SETTING_DEFS[index];
+  if (def.type == SETTING_TEXT) {
+    portENTER_CRITICAL(&textMux);
+    strlcpy(buf, (def.flags & SETTING_SECRET) ? "" : (const char*)fieldOf(def), len);
+    portEXIT_CRITICAL(&textMux);
+  } else if (def.type == SETTING_INT) {
+    snprintf(buf, len, "%ld", (long)*(int32_t*)fieldOf(def));
+  } else {
+    snprintf(buf, len, "%g", *(float*)fieldOf(def));
+  }
+}
+
+void settingCopyText(const char* field, char* buf, size_t len) {
+  portENTER_CRITICAL(&textMux);
+  strlcpy(buf, field, len);
+  portEXIT_CRITICAL(&textMux);
+}
+
+bool settingIsSet(int index) {
+  const SettingDef& def = SETTING_DEFS[index];
+  return def.type != SETTING_TEXT || ((const char*)fieldOf(def))[0] != '\0';
+}
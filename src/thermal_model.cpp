@@ -0,0 +1,90 @@
+#include <math.h>
+#include "thermal_model.h"
+
+ThermalModel::ThermalModel() {
+  reset();
+}
+
+void ThermalModel::reset() {
+  for (int i = 0; i < 3; i++) {
+    theta[i] = 0;
+    for (int j = 0; j < 3; j++) P[i][j] = i == j ? THERMAL_P_INIT : 0;
+  }
+  havePrevious = false;
+  previousT = 0;
+  previousU = 0;
+  updateCount = 0;
+}
+
+void ThermalModel::update(float meanTempF, float meanDuty) {
+  double t = meanTempF / THERMAL_TEMP_SCALE;
+  double u = meanDuty;
+
+  if (!havePrevious) {
+    previousT = t;
+    previousU = u;
+    havePrevious = true;
+    return;
+  }
+
+  // Regressor from the previous step, target is the change since then
+  double phi[3] = { previousU, previousT, 1.0 };
+  double y = t - previousT;
+  previousT = t;
+  previousU = u;
+
+  double Pphi[3];
+  for (int i = 0; i < 3; i++) {
+    Pphi[i] = P[i][0] * phi[0] + P[i][1] * phi[1] + P[i][2] * phi[2];
+  }
+  double trace = P[0][0] + P[1][1] + P[2][2];
+  // A room sitting idle at ambient excites nothing; forgetting then would
+  // only blow the covariance up, so hold it once it is large
+  double lambda = trace < THERMAL_P_TRACE_MAX ? THERMAL_FORGETTING : 1.0;
+  double denom = lambda + phi[0] * Pphi[0] + phi[1] * Pphi[1] + phi[2] * Pphi[2];
+
+  double error = y - (theta[0] * phi[0] + theta[1] * phi[1] + theta[2] * phi[2]);
+  double gain[3];
+  for (int i = 0; i < 3; i++) {
+    gain[i] = Pphi[i] / denom;
+    theta[i] += gain[i] * error;
+  }
+
+  // P = (P - K phi' P) / lambda, kept symmetric
+  for (int i = 0; i < 3; i++) {
+    for (int j = i; j < 3; j++) {
+      double v = (P[i][j] - gain[i] * Pphi[j]) / lambda;
+      P[i][j] = v;
+      P[j][i] = v;
+    }
+  }
+  updateCount++;
+}
+
+bool ThermalModel::converged() const {
+  // b must be a real, not-absurdly-slow cooling term
+  return updateCount >= THERMAL_MIN_UPDATES && theta[0] > 0 &&
+         theta[1] < -1e-5 && theta[1] > -1.0;
+}
+
+float ThermalModel::steadyStateF(float duty) const {
+  if (theta[1] == 0) return 0;
+  return -(theta[0] * duty + theta[2]) / theta[1] * THERMAL_TEMP_SCALE;
+}
+
+float ThermalModel::timeConstantS() const {
+  if (theta[1] >= 0) return 0;
+  return -THERMAL_STEP_S / log(1.0 + theta[1]);
+}
+
+long ThermalModel::etaSeconds(float tempF, float setpointF, float duty) const {
+  if (!converged()) return -1;
+  if (tempF >= setpointF) return 0;
+
+  // T approaches the steady state geometrically: the gap shrinks by
+  // (1 + b) every step
+  double finalF = steadyStateF(duty);
+  if (finalF <= setpointF) return -1;
+  double steps = log((finalF - setpointF) / (finalF - tempF)) / log(1.0 + theta[1]);
+  return lround(steps * THERMAL_STEP_S);
+}
@@ -0,0 +1,111 @@
+#include "thermostat.h"
+
+static float clampf(float value, float lo, float hi) {
+  return value < lo ? lo : (value > hi ? hi : value);
+}
+
+Thermostat::Thermostat()
+    : mode(THERMOSTAT_PID), setpoint(0), duty(0), integral(0), dFiltered(0),
+      lastTempF(0), lastUpdateMs(0), havePrevious(false), hysteresisOn(false),
+      windowStartMs(0) {
+  PidGains defaults = { THERMOSTAT_DEFAULT_KP, THERMOSTAT_DEFAULT_KI, THERMOSTAT_DEFAULT_KD };
+  setGains(defaults);
+}
+
+void Thermostat::setGains(const PidGains& newGains) {
+  gains = newGains;
+  mode = (gains.kp == 0 && gains.ki == 0 && gains.kd == 0) ? THERMOSTAT_HYSTERESIS : THERMOSTAT_PID;
+}
+
+void Thermostat::reset(unsigned long nowMs) {
+  duty = 0;
+  integral = 0;
+  dFiltered = 0;
+  havePrevious = false;
+  hysteresisOn = false;
+  windowStartMs = nowMs;
+}
+
+void Thermostat::update(float tempF, unsigned long nowMs) {
+  float error = setpoint - tempF;
+
+  if (mode == THERMOSTAT_HYSTERESIS) {
+    if (tempF <= setpoint - THERMOSTAT_HYSTERESIS_F) hysteresisOn = true;
+    if (tempF >= setpoint) hysteresisOn = false;
+    duty = hysteresisOn ? 1.0f : 0.0f;
+  } else if (error > THERMOSTAT_PID_BAND_F) {
+    // Cold start: flat out, and keep the integral empty so it can't wind
+    // up during the long climb and overshoot later
+    duty = 1.0f;
+    integral = 0;
+    dFiltered = 0;
+  } else {
+    float dt = havePrevious ? (nowMs - lastUpdateMs) / 1000.0f : 0;
+
+    // Derivative on measurement, so setpoint changes don't kick the output
+    if (dt > 0) {
+      float slope = (tempF - lastTempF) / dt;
+      dFiltered += THERMOSTAT_D_FILTER * (slope - dFiltered);
+    }
+
+    float p = gains.kp * error;
+    float d = -gains.kd * dFiltered;
+
+    // Anti-windup: only integrate when it doesn't push further into a
+    // saturated output
+    float candidate = integral + gains.ki * error * dt;
+    float unclamped = p + candidate + d;
+    bool saturatingHigh = unclamped > 1.0f && error > 0;
+    bool saturatingLow = unclamped < 0.0f && error < 0;
+    if (!saturatingHigh && !saturatingLow) {
+      integral = clampf(candidate, 0.0f, 1.0f);
+    }
+
+    duty = clampf(p + integral + d, 0.0f, 1.0f);
+  }
+
+  lastTempF = tempF;
+  lastUpdateMs = nowMs;
+  havePrevious = true;
+}
+
+void Thermostat::fault() {
+  duty = 0;
+  hysteresisOn = false;
+  havePrevious = false;
+}
+
+void Thermostat::setOutput(float newDuty) {
+  duty = clampf(newDuty, 0.0f, 1.0f);
+  havePrevious = false;
+}
+
+void Thermostat::advanceWindow(unsigned long nowMs) {
+  unsigned long elapsed = nowMs - windowStartMs;
+  if (elapsed >= THERMOSTAT_WINDOW_MS) {
+    windowStartMs += (elapsed / THERMOSTAT_WINDOW_MS) * THERMOSTAT_WINDOW_MS;
+  }
+}
+
+unsigned long Thermostat::onTimeMs() const {
+  unsigned long onMs = (unsigned long)(duty * THERMOSTAT_WINDOW_MS + 0.5f);
+  if (onMs < THERMOSTAT_MIN_PULSE_MS) return 0;
+  if (THERMOSTAT_WINDOW_MS - onMs < THERMOSTAT_MIN_PULSE_MS) return THERMOSTAT_WINDOW_MS;
+  return onMs;
+}
+
+bool Thermostat::heaterOn(unsigned long nowMs) {
+  advanceWindow(nowMs);
+  return nowMs - windowStartMs < onTimeMs();
+}
+
+unsigned long Thermostat::nextSwitchMs(unsigned long nowMs) {
+  advanceWindow(nowMs);
+  unsigned long into = nowMs - windowStartMs;
+  unsigned long onMs = onTimeMs();
+
+  if (onMs == 0 || onMs == THERMOSTAT_WINDOW_MS) {
+    return THERMOSTAT_WINDOW_MS - into;   // Nothing switches; recheck next window
+  }
+  return into < onMs ? onMs - into : THERMOSTAT_WINDOW_MS - into;
+}
@@ -0,0 +1,18 @@
+#include "wake.h"
+
+static TaskHandle_t loopTaskHandle = NULL;
+
+void wakeBegin() {
+  loopTaskHandle = xTaskGetCurrentTaskHandle();
+}
+
+void wakeLoop(uint32_t reasons) {
+  if (loopTaskHandle == NULL) return;
+  xTaskNotify(loopTaskHandle, reasons, eSetBits);
+}
+
+uint32_t waitForWake(TickType_t timeout) {
+  uint32_t reasons = 0;
+  xTaskNotifyWait(0, ULONG_MAX, &reasons, timeout);
+  return reasons;
+}
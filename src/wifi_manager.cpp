@@ -0,0 +1,198 @@
+#include <WiFi.h>
+#include <Preferences.h>
+#include <secrets.h>
+#include "wifi_manager.h"
+#include "settings.h"
+
+#define WIFI_NAMESPACE "wifi"
+
+struct Network {
+  char ssid[SETTING_SSID_LEN];
+  char password[SETTING_PWD_LEN];
+};
+
+static const int NETWORK_COUNT = 2;
+
+// Credentials from /config win over the ones compiled in from secrets.h.
+// Copied at every join, so an edit takes effect on the next reconnect.
+static Network networkAt(int index) {
+  Network net;
+  settingCopyText(index == 0 ? settings.wifiSsid1 : settings.wifiSsid2, net.ssid, sizeof(net.ssid));
+  settingCopyText(index == 0 ? settings.wifiPwd1 : settings.wifiPwd2, net.password, sizeof(net.password));
+  if (net.ssid[0] == '\0') {
+    strlcpy(net.ssid, index == 0 ? WIFI_SSID_1 : WIFI_SSID_2, sizeof(net.ssid));
+    strlcpy(net.password, index == 0 ? WIFI_PWD_1 : WIFI_PWD_2, sizeof(net.password));
+  }
+  return net;
+}
+
+// Last access point that worked, mirrored from NVS
+struct ApCache {
+  bool valid;
+  uint8_t network;     // 0 = SSID 1, 1 = SSID 2
+  uint8_t bssid[6];
+  uint8_t channel;
+};
+
+static TaskHandle_t wifiTaskHandle = NULL;
+static void (*connectedCallback)() = NULL;
+static ApCache cache;
+
+static volatile WifiState state = WIFI_STARTING;
+static volatile unsigned long connectCount = 0;
+static volatile unsigned long fastConnectCount = 0;
+static volatile unsigned long dropCount = 0;
+static volatile unsigned long lastConnectMs = 0;
+
+static void loadCache() {
+  Preferences prefs;
+  cache.valid = false;
+  if (!prefs.begin(WIFI_NAMESPACE, true)) return;
+  if (prefs.getBytesLength("bssid") == sizeof(cache.bssid)) {
+    prefs.getBytes("bssid", cache.bssid, sizeof(cache.bssid));
+    cache.network = prefs.getUChar("net", 0);
+    cache.channel = prefs.getUChar("chan", 0);
+    cache.valid = cache.network < NETWORK_COUNT && cache.channel != 0;
+  }
+  prefs.end();
+}
+
+// Only writes when the access point actually changed, to spare the flash
+static void saveCache(uint8_t network) {
+  ApCache fresh;
+  fresh.valid = true;
+  fresh.network = network;
+  memcpy(fresh.bssid, WiFi.BSSID(), sizeof(fresh.bssid));
+  fresh.channel = WiFi.channel();
+  if (cache.valid && cache.network == fresh.network && cache.channel == fresh.channel &&
+      memcmp(cache.bssid, fresh.bssid, sizeof(fresh.bssid)) == 0) {
+    return;
+  }
+
+  Preferences prefs;
+  if (!prefs.begin(WIFI_NAMESPACE, false)) return;
+  prefs.putBytes("bssid", fresh.bssid, sizeof(fresh.bssid));
+  prefs.putUChar("net", fresh.network);
+  prefs.putUChar("chan", fresh.channel);
+  prefs.end();
+  cache = fresh;
+}
+
+static void wifiTask(void* param) {
+  int network = cache.valid ? cache.network : 0;
+  int failedThisRound = 0;
+  unsigned long retryMs = WIFI_RETRY_MS;
+  unsigned long attemptStart = 0;
+  unsigned long timeout = 0;
+
+  // Starts joining network, on the cached access point if fast
+  auto beginJoin = [&](bool fast) {
+    WiFi.disconnect();
+    Network net = networkAt(network);
+    if (fast) {
+      Serial.printf("WiFi: joining %s on cached channel %u\n", net.ssid, cache.channel);
+      WiFi.begin(net.ssid, net.password, cache.channel, cache.bssid);
+      state = WIFI_FAST_CONNECT;
+      timeout = WIFI_FAST_TIMEOUT_MS;
+    } else {
+      Serial.printf("WiFi: scanning for %s\n", net.ssid);
+      WiFi.begin(net.ssid, net.password);
+      state = WIFI_CONNECTING;
+      timeout = WIFI_SCAN_TIMEOUT_MS;
+    }
+    attemptStart = millis();
+  };
+
+  beginJoin(cache.valid);
+
+  for (;;) {
+    vTaskDelay(pdMS_TO_TICKS(WIFI_POLL_MS));
+    bool up = WiFi.status() == WL_CONNECTED;
+
+    switch (state) {
+      case WIFI_FAST_CONNECT:
+      case WIFI_CONNECTING:
+        if (up) {
+          lastConnectMs = millis() - attemptStart;
+          connectCount++;
+          if (state == WIFI_FAST_CONNECT) fastConnectCount++;
+          Serial.printf("WiFi: connected to %s in %lu ms, IP %s\n", networkAt(network).ssid,
+                        lastConnectMs, WiFi.localIP().toString().c_str());
+          saveCache(network);
+          state = WIFI_CONNECTED;
+          failedThisRound = 0;
+          retryMs = WIFI_RETRY_MS;
+          if (connectedCallback) connectedCallback();
+        } else if (millis() - attemptStart >= timeout) {
+          if (state == WIFI_FAST_CONNECT) {
+            beginJoin(false);   // Same SSID, wherever it is now
+          } else if (++failedThisRound < NETWORK_COUNT) {
+            network = (network + 1) % NETWORK_COUNT;
+            beginJoin(false);
+          } else {
+            Serial.printf("WiFi: no network, retrying in %lu s\n", retryMs / 1000);
+            WiFi.disconnect();
+            state = WIFI_WAITING;
+            attemptStart = millis();
+          }
+        }
+        break;
+
+      case WIFI_CONNECTED:
+        if (!up) {
+          dropCount++;
+          Serial.println("WiFi: connection lost");
+          failedThisRound = 0;
+          beginJoin(cache.valid && cache.network == network);
+        }
+        break;
+
+      case WIFI_WAITING:
+        if (millis() - attemptStart >= retryMs) {
+          retryMs = min(retryMs * 2, (unsigned long)WIFI_RETRY_MAX_MS);
+          failedThisRound = 0;
+          network = cache.valid ? cache.network : 0;   // Start each round with the best bet
+          beginJoin(false);
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
+}
+
+void wifiManagerBegin(void (*onConnected)()) {
+  if (wifiTaskHandle != NULL) return;
+  connectedCallback = onConnected;
+
+  // The manager does its own reconnecting and caching; the core's versions
+  // would fight it and rewrite its NVS config on every join
+  WiFi.persistent(false);
+  WiFi.setAutoReconnect(false);
+  WiFi.mode(WIFI_STA);
+  loadCache();
+
+  xTaskCreatePinnedToCore(wifiTask, "wifi", WIFI_TASK_STACK, NULL,
+                          WIFI_TASK_PRIORITY, &wifiTaskHandle, WIFI_TASK_CORE);
+}
+
+WifiStats wifiGetStats() {
+  WifiStats stats;
+  stats.state = state;
+  stats.connects = connectCount;
+  stats.fastConnects = fastConnectCount;
+  stats.drops = dropCount;
+  stats.lastConnectMs = lastConnectMs;
+  return stats;
+}
+
+const char* wifiStateName(WifiState s) {
+  switch (s) {
+    case WIFI_FAST_CONNECT: return "fast-connect";
+    case WIFI_CONNECTING: return "connecting";
+    case WIFI_CONNECTED: return "connected";
+    case WIFI_WAITING: return "waiting";
+    default: return "starting";
+  }
+}
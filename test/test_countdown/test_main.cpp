@@ -0,0 +1,69 @@
+#include <unity.h>
+#include "countdown.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void test_counts_down_from_start() {
+  Countdown countdown;
+  countdown.set(90000);
+  countdown.start(1000);
+  TEST_ASSERT_FALSE(countdown.update(31000));
+  TEST_ASSERT_EQUAL_UINT32(60000, countdown.remainingMs());
+}
+
+static void test_expires_once_deadline_passes() {
+  Countdown countdown;
+  countdown.set(5000);
+  countdown.start(0);
+  TEST_ASSERT_FALSE(countdown.update(4999));
+  TEST_ASSERT_TRUE(countdown.update(5000));
+  TEST_ASSERT_TRUE(countdown.update(9000));
+  TEST_ASSERT_EQUAL_UINT32(0, countdown.remainingMs());
+}
+
+static void test_survives_millis_wrap() {
+  Countdown countdown;
+  countdown.set(10000);
+  countdown.start((unsigned long)-0x1000);
+  TEST_ASSERT_FALSE(countdown.update(0x100));
+  TEST_ASSERT_EQUAL_UINT32(10000 - 0x1100, countdown.remainingMs());
+}
+
+static void test_add_is_capped() {
+  Countdown countdown;
+  countdown.set(80 * 60000UL);
+  countdown.start(0);
+  countdown.add(15 * 60000UL, 90 * 60000UL, 0);
+  TEST_ASSERT_EQUAL_UINT32(90 * 60000UL, countdown.remainingMs());
+  TEST_ASSERT_FALSE(countdown.update(60000));
+  TEST_ASSERT_EQUAL_UINT32(89 * 60000UL, countdown.remainingMs());
+}
+
+static void test_format_rounds_down() {
+  Countdown countdown;
+  char buf[8];
+  countdown.set(61999);
+  countdown.format(buf, sizeof(buf));
+  TEST_ASSERT_EQUAL_STRING("01:01", buf);
+  countdown.set(0);
+  countdown.format(buf, sizeof(buf));
+  TEST_ASSERT_EQUAL_STRING("00:00", buf);
+}
+
+static void test_next_second_edge() {
+  Countdown countdown;
+  countdown.set(61250);
+  TEST_ASSERT_EQUAL_UINT32(251, countdown.msToNextSecond());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_counts_down_from_start);
+  RUN_TEST(test_expires_once_deadline_passes);
+  RUN_TEST(test_survives_millis_wrap);
+  RUN_TEST(test_add_is_capped);
+  RUN_TEST(test_format_rounds_down);
+  RUN_TEST(test_next_second_edge);
+  return UNITY_END();
+}
@@ -0,0 +1,88 @@
+#include <unity.h>
+#include "delta_codec.h"
+
+// decodeHistory() in web/index.html follows the same rules as DeltaDecoder:
+// keep the two in step when the format changes.
+
+void setUp() {}
+void tearDown() {}
+
+// Encodes samples back to back, then decodes them and compares
+static void roundTrip(const int16_t* samples, size_t count) {
+  uint8_t buf[256 * DELTA_MAX_BYTES];
+  DeltaEncoder encoder;
+  size_t len = 0;
+  for (size_t i = 0; i < count; i++) {
+    size_t n = encoder.encode(samples[i], buf + len);
+    TEST_ASSERT_TRUE(n >= 1 && n <= DELTA_MAX_BYTES);
+    len += n;
+  }
+
+  DeltaDecoder decoder;
+  size_t pos = 0;
+  for (size_t i = 0; i < count; i++) {
+    int16_t centiF;
+    size_t n = decoder.decode(buf + pos, len - pos, centiF);
+    TEST_ASSERT_TRUE(n > 0);
+    TEST_ASSERT_EQUAL(samples[i], centiF);
+    pos += n;
+  }
+  TEST_ASSERT_EQUAL(len, pos);
+}
+
+static void test_steady_temperature_is_one_byte() {
+  DeltaEncoder encoder;
+  uint8_t out[DELTA_MAX_BYTES];
+  encoder.encode(18000, out);
+  TEST_ASSERT_EQUAL(1, encoder.encode(18000, out));
+  TEST_ASSERT_EQUAL(1, out[0]);   // zigzag(0) + 1
+  TEST_ASSERT_EQUAL(1, encoder.encode(18010, out));
+}
+
+static void test_round_trip_heat_up() {
+  int16_t samples[200];
+  for (int i = 0; i < 200; i++) samples[i] = 7000 + i * 55 - (i % 7) * 3;
+  roundTrip(samples, 200);
+}
+
+static void test_round_trip_extremes() {
+  const int16_t samples[] = { INT16_MAX, DELTA_GAP + 1, INT16_MAX, 0, -1, 1, DELTA_GAP + 1, 0 };
+  roundTrip(samples, sizeof(samples) / sizeof(samples[0]));
+}
+
+static void test_gaps_keep_the_previous_value() {
+  const int16_t samples[] = { 15000, DELTA_GAP, DELTA_GAP, 15020, DELTA_GAP, 14990 };
+  roundTrip(samples, sizeof(samples) / sizeof(samples[0]));
+
+  DeltaEncoder encoder;
+  uint8_t out[DELTA_MAX_BYTES];
+  encoder.encode(15000, out);
+  TEST_ASSERT_EQUAL(1, encoder.encode(DELTA_GAP, out));
+  TEST_ASSERT_EQUAL(0, out[0]);
+  encoder.encode(15000, out);
+  TEST_ASSERT_EQUAL(1, out[0]);   // Delta from before the gap
+}
+
+static void test_truncated_input_consumes_nothing() {
+  DeltaEncoder encoder;
+  uint8_t buf[DELTA_MAX_BYTES];
+  size_t len = encoder.encode(INT16_MAX, buf);
+  TEST_ASSERT_EQUAL(3, len);
+
+  DeltaDecoder decoder;
+  int16_t centiF = 123;
+  TEST_ASSERT_EQUAL(0, decoder.decode(buf, len - 1, centiF));
+  TEST_ASSERT_EQUAL(0, decoder.decode(buf, 0, centiF));
+  TEST_ASSERT_EQUAL(len, decoder.decode(buf, len, centiF));
+  TEST_ASSERT_EQUAL(INT16_MAX, centiF);
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_steady_temperature_is_one_byte);
+  RUN_TEST(test_round_trip_heat_up);
+  RUN_TEST(test_round_trip_extremes);
+  RUN_TEST(test_gaps_keep_the_previous_value);
+  RUN_TEST(test_truncated_input_consumes_nothing);
+  return UNITY_END();
+}
@@ -0,0 +1,62 @@
+#include <unity.h>
+#include "energy.h"
+
+void setUp() {}
+void tearDown() {}
+
+static const int32_t DAY_1 = 2026100;    // (year * 1000) + day of year
+static const int32_t DAY_2 = 2026101;
+static const int32_t MONTH = 202604;
+
+static void test_adds_on_time_to_day_and_month() {
+  EnergyMeter meter;
+  meter.update(1000, DAY_1, MONTH);
+  meter.update(3000, DAY_1, MONTH);
+  TEST_ASSERT_EQUAL_UINT64(3000, meter.dayOnUs());
+  TEST_ASSERT_EQUAL_UINT64(3000, meter.monthOnUs());
+}
+
+static void test_new_day_starts_from_zero() {
+  EnergyMeter meter;
+  meter.update(1000, DAY_1, MONTH);
+  meter.update(1500, DAY_2, MONTH);
+  TEST_ASSERT_EQUAL_UINT64(500, meter.dayOnUs());
+  TEST_ASSERT_EQUAL_UINT64(1500, meter.monthOnUs());
+}
+
+// Rebooted into a new day: what ran before the clock synced belongs to
+// that new day, not to the restored one the sync then resets
+static void test_keeps_on_time_from_before_the_clock_is_set() {
+  EnergyMeter meter;
+  meter.restore(DAY_1, 7000, MONTH, 9000);
+  meter.update(2000, ENERGY_NO_KEY, ENERGY_NO_KEY);
+  TEST_ASSERT_EQUAL_UINT64(7000, meter.dayOnUs());
+  TEST_ASSERT_EQUAL_UINT64(2000, meter.heldOnUs());
+
+  meter.update(2500, DAY_2, MONTH);
+  TEST_ASSERT_EQUAL_UINT64(2500, meter.dayOnUs());
+  TEST_ASSERT_EQUAL_UINT64(11500, meter.monthOnUs());
+  TEST_ASSERT_EQUAL_UINT64(0, meter.heldOnUs());
+}
+
+static void test_first_date_adopts_a_period_saved_without_one() {
+  EnergyMeter meter;
+  meter.restore(ENERGY_NO_KEY, 4000, ENERGY_NO_KEY, 4000);
+  meter.update(1000, DAY_1, MONTH);
+  TEST_ASSERT_EQUAL_UINT64(5000, meter.dayOnUs());
+  TEST_ASSERT_EQUAL(DAY_1, meter.dayKey());
+}
+
+static void test_kwh_from_on_time() {
+  TEST_ASSERT_FLOAT_WITHIN(1e-4f, 2.0f, energyKwh(3600ULL * 1000000ULL, 2000.0f));
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_adds_on_time_to_day_and_month);
+  RUN_TEST(test_new_day_starts_from_zero);
+  RUN_TEST(test_keeps_on_time_from_before_the_clock_is_set);
+  RUN_TEST(test_first_date_adopts_a_period_saved_without_one);
+  RUN_TEST(test_kwh_from_on_time);
+  return UNITY_END();
+}
@@ -0,0 +1,90 @@
+#include <unity.h>
+#include "history.h"
+
+void setUp() {}
+void tearDown() {}
+
+// Sample n is n % 300 whole degrees (in range of the int16 centi-degrees),
+// so a read shows which sample it got
+static int16_t sampleCentiF(uint32_t n) {
+  return (int16_t)(n % 300 * 100);
+}
+
+static void fill(TempHistory& history, uint32_t samples) {
+  for (uint32_t i = 0; i < samples; i++) {
+    history.add(sampleCentiF(i) / 100.0f, true, i);
+  }
+}
+
+static void test_reads_back_what_was_added() {
+  static TempHistory history;
+  fill(history, 10);
+  TEST_ASSERT_EQUAL(10, history.written(0));
+  TEST_ASSERT_EQUAL(10, history.count(0));
+
+  int16_t centiF;
+  TEST_ASSERT_TRUE(history.read(0, 0, centiF));
+  TEST_ASSERT_EQUAL(0, centiF);
+  TEST_ASSERT_TRUE(history.read(0, 9, centiF));
+  TEST_ASSERT_EQUAL(900, centiF);
+  TEST_ASSERT_FALSE(history.read(0, 10, centiF));   // Not written yet
+}
+
+// With the ring exactly one lap ahead, seq's slot holds seq + capacity
+static void test_refuses_the_slot_a_lap_ahead() {
+  static TempHistory history;
+  uint16_t capacity = HISTORY_CAPACITY[0];
+  fill(history, capacity + 5);
+  uint32_t written = history.written(0);
+
+  int16_t centiF = 12345;
+  TEST_ASSERT_FALSE(history.read(0, written - capacity, centiF));
+  TEST_ASSERT_FALSE(history.read(0, written - capacity - 1, centiF));
+
+  uint32_t oldest = written - capacity + 1;
+  TEST_ASSERT_TRUE(history.read(0, oldest, centiF));
+  TEST_ASSERT_EQUAL(sampleCentiF(oldest), centiF);
+}
+
+static void test_count_offers_only_readable_samples() {
+  static TempHistory history;
+  uint16_t capacity = HISTORY_CAPACITY[0];
+  fill(history, capacity);
+  TEST_ASSERT_EQUAL(capacity - 1, history.count(0));
+
+  uint32_t written = history.written(0);
+  int16_t centiF;
+  for (uint32_t seq = written - history.count(0); seq < written; seq++) {
+    TEST_ASSERT_TRUE(history.read(0, seq, centiF));
+    TEST_ASSERT_EQUAL(sampleCentiF(seq), centiF);
+  }
+}
+
+static void test_averages_into_the_next_tier() {
+  static TempHistory history;
+  for (uint32_t i = 0; i < 10; i++) {
+    history.add(100.0f + i, i != 3, i);   // One gap, left out of the average
+  }
+  TEST_ASSERT_EQUAL(1, history.written(1));
+  int16_t centiF;
+  TEST_ASSERT_TRUE(history.read(1, 0, centiF));
+  TEST_ASSERT_EQUAL((int16_t)((100 + 101 + 102 + 104 + 105 + 106 + 107 + 108 + 109) * 100 / 9), centiF);
+}
+
+static void test_gap_is_stored_as_no_sample() {
+  static TempHistory history;
+  history.add(150.0f, false, 0);
+  int16_t centiF;
+  TEST_ASSERT_TRUE(history.read(0, 0, centiF));
+  TEST_ASSERT_EQUAL(HISTORY_NO_SAMPLE, centiF);
+}
+
+int main(int argc, char** argv) {
+  UNITY_BEGIN();
+  RUN_TEST(test_reads_back_what_was_added);
+  RUN_TEST(test_refuses_the_slot_a_lap_ahead);
+  RUN_TEST(test_count_offers_only_readable_samples);
+  RUN_TEST(test_averages_into_the_next_tier);
+  RUN_TEST(test_gap_is_stored_as_no_sample);
+  return UNITY_END();
+}
@@ -0,0 +1,54 @@
+#include <unity.h>
+#include "menu.h"
+
+static const char* const ITEMS[] = { "Start", "Stop", "Set", "Tune" };
+
+void setUp() {}
+void tearDown() {}
+
+static void test_rotate_wraps_both_ways() {
+  Menu menu(ITEMS, 4);
+  menu.rotate(-1, 90);
+  TEST_ASSERT_EQUAL_STRING("Tune", menu.label());
+  menu.rotate(2, 90);
+  TEST_ASSERT_EQUAL_STRING("Stop", menu.label());
+  menu.rotate(9, 90);
+  TEST_ASSERT_EQUAL_STRING("Set", menu.label());
+}
+
+static void test_press_selects_item() {
+  Menu menu(ITEMS, 4);
+  TEST_ASSERT_EQUAL(MENU_SELECTED, menu.press());
+  TEST_ASSERT_EQUAL_STRING("Start", menu.label());
+}
+
+static void test_set_time_rolls_minutes() {
+  Menu menu(ITEMS, 4);
+  menu.beginSetTime();
+  TEST_ASSERT_TRUE(menu.isSettingTime());
+  menu.rotate(-1, 90);
+  TEST_ASSERT_EQUAL(90, menu.minutes());
+  menu.rotate(3, 90);
+  TEST_ASSERT_EQUAL(2, menu.minutes());
+  TEST_ASSERT_EQUAL_STRING("Start", menu.label());   // Items don't move meanwhile
+  TEST_ASSERT_EQUAL(MENU_TIME_SET, menu.press());
+  TEST_ASSERT_FALSE(menu.isSettingTime());
+}
+
+static void test_long_press_backs_out() {
+  Menu menu(ITEMS, 4);
+  menu.beginSetTime();
+  menu.rotate(5, 90);
+  menu.longPress();
+  TEST_ASSERT_FALSE(menu.isSettingTime());
+  TEST_ASSERT_EQUAL(MENU_SELECTED, menu.press());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_rotate_wraps_both_ways);
+  RUN_TEST(test_press_selects_item);
+  RUN_TEST(test_set_time_rolls_minutes);
+  RUN_TEST(test_long_press_backs_out);
+  return UNITY_END();
+}
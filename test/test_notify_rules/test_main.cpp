@@ -0,0 +1,78 @@
+#include <string.h>
+#include <unity.h>
+#include "notify_rules.h"
+
+void setUp() {}
+void tearDown() {}
+
+static NotifyMessage message(NotifyEvent event, const char* text) {
+  NotifyMessage msg;
+  msg.event = event;
+  strncpy(msg.text, text, sizeof(msg.text));
+  msg.text[sizeof(msg.text) - 1] = '\0';
+  return msg;
+}
+
+static void test_parse_event_lists() {
+  uint32_t mask = 0;
+  TEST_ASSERT_TRUE(parseNotifyEvents("", mask));
+  TEST_ASSERT_EQUAL_HEX32(NOTIFY_ALL_EVENTS, mask);
+  TEST_ASSERT_TRUE(parseNotifyEvents("none", mask));
+  TEST_ASSERT_EQUAL_HEX32(0, mask);
+  TEST_ASSERT_TRUE(parseNotifyEvents("on,OFF,left", mask));
+  TEST_ASSERT_EQUAL_HEX32((1UL << NOTIFY_ON) | (1UL << NOTIFY_OFF) | (1UL << NOTIFY_MINUTES_LEFT), mask);
+  TEST_ASSERT_FALSE(parseNotifyEvents("on,bogus", mask));
+}
+
+static void test_first_message_goes_straight_out() {
+  NotifyCoalescer coalescer;
+  TEST_ASSERT_EQUAL_UINT32(NOTIFY_NEVER, coalescer.msUntilDue(0));
+  TEST_ASSERT_TRUE(coalescer.post(message(NOTIFY_TIME_ADDED, "a"), 0, 30000));
+  TEST_ASSERT_EQUAL_UINT32(30000, coalescer.msUntilDue(0));
+}
+
+static void test_repeats_fold_into_one_trailing_message() {
+  NotifyCoalescer coalescer;
+  NotifyMessage out;
+  coalescer.post(message(NOTIFY_TIME_ADDED, "1"), 0, 30000);
+  for (int i = 2; i <= 5; i++) {
+    char text[4] = { (char)('0' + i), 0 };
+    TEST_ASSERT_FALSE(coalescer.post(message(NOTIFY_TIME_ADDED, text), i * 1000, 30000));
+  }
+  TEST_ASSERT_FALSE(coalescer.due(29999, out));
+  TEST_ASSERT_TRUE(coalescer.due(30000, out));
+  TEST_ASSERT_EQUAL_STRING("5 (x4)", out.text);
+  TEST_ASSERT_FALSE(coalescer.due(30000, out));
+
+  // Quiet for a whole window, so the next one goes straight out again
+  TEST_ASSERT_FALSE(coalescer.due(60000, out));
+  TEST_ASSERT_TRUE(coalescer.post(message(NOTIFY_TIME_ADDED, "6"), 60001, 30000));
+}
+
+static void test_on_and_off_share_a_slot() {
+  NotifyCoalescer coalescer;
+  NotifyMessage out;
+  TEST_ASSERT_TRUE(coalescer.post(message(NOTIFY_ON, "on"), 0, 30000));
+  TEST_ASSERT_FALSE(coalescer.post(message(NOTIFY_OFF, "off"), 1000, 30000));
+  TEST_ASSERT_TRUE(coalescer.due(30000, out));
+  TEST_ASSERT_EQUAL(NOTIFY_OFF, out.event);
+  TEST_ASSERT_EQUAL_STRING("off", out.text);
+}
+
+static void test_urgent_and_unwindowed_skip_coalescing() {
+  NotifyCoalescer coalescer;
+  TEST_ASSERT_TRUE(coalescer.post(message(NOTIFY_OVER_TEMP, "hot"), 0, 30000));
+  TEST_ASSERT_TRUE(coalescer.post(message(NOTIFY_OVER_TEMP, "hot"), 1, 30000));
+  TEST_ASSERT_TRUE(coalescer.post(message(NOTIFY_REACHED, "r"), 0, 0));
+  TEST_ASSERT_TRUE(coalescer.post(message(NOTIFY_REACHED, "r"), 1, 0));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_parse_event_lists);
+  RUN_TEST(test_first_message_goes_straight_out);
+  RUN_TEST(test_repeats_fold_into_one_trailing_message);
+  RUN_TEST(test_on_and_off_share_a_slot);
+  RUN_TEST(test_urgent_and_unwindowed_skip_coalescing);
+  return UNITY_END();
+}
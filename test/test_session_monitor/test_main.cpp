@@ -0,0 +1,78 @@
+#include <unity.h>
+#include "session_monitor.h"
+
+#define WARN_MS (10 * 60000UL)
+
+void setUp() {}
+void tearDown() {}
+
+static void test_on_and_off_edges() {
+  SessionMonitor monitor;
+  TEST_ASSERT_EQUAL_HEX32(0, monitor.update(false, 70, 180, 0, WARN_MS));
+  TEST_ASSERT_EQUAL_HEX32(0, monitor.update(false, 200, 180, 0, WARN_MS));   // Hot but off: quiet
+  TEST_ASSERT_EQUAL_HEX32(SESSION_EVENT_ON, monitor.update(true, 70, 180, 3600000, WARN_MS));
+  TEST_ASSERT_EQUAL_HEX32(0, monitor.update(true, 70, 180, 3600000, WARN_MS));
+  TEST_ASSERT_EQUAL_HEX32(SESSION_EVENT_OFF, monitor.update(false, 70, 180, 0, WARN_MS));
+}
+
+static void test_reached_fires_once_per_session() {
+  SessionMonitor monitor;
+  monitor.update(true, 70, 180, 3600000, WARN_MS);
+  TEST_ASSERT_EQUAL_HEX32(SESSION_EVENT_REACHED, monitor.update(true, 180, 180, 3600000, WARN_MS));
+  TEST_ASSERT_EQUAL_HEX32(0, monitor.update(true, 181, 180, 3600000, WARN_MS));
+}
+
+static void test_reached_after_dip_and_recovery() {
+  SessionMonitor monitor;
+  monitor.update(true, 70, 180, 3600000, WARN_MS);
+  TEST_ASSERT_EQUAL_HEX32(SESSION_EVENT_REACHED, monitor.update(true, 180, 180, 3600000, WARN_MS));
+
+  // Door opened and the room recovered: the same session, no second message
+  TEST_ASSERT_EQUAL_HEX32(0, monitor.update(true, 165, 180, 3500000, WARN_MS));
+  TEST_ASSERT_EQUAL_HEX32(0, monitor.update(true, 180, 180, 3400000, WARN_MS));
+
+  // A moved setpoint makes the next crossing news again
+  monitor.rearm();
+  TEST_ASSERT_EQUAL_HEX32(0, monitor.update(true, 180, 190, 3300000, WARN_MS));
+  TEST_ASSERT_EQUAL_HEX32(SESSION_EVENT_REACHED, monitor.update(true, 190, 190, 3200000, WARN_MS));
+
+  // So does a new session, even when the room is still hot
+  monitor.update(false, 190, 190, 0, WARN_MS);
+  TEST_ASSERT_EQUAL_HEX32(SESSION_EVENT_ON | SESSION_EVENT_REACHED,
+                          monitor.update(true, 190, 190, 3600000, WARN_MS));
+}
+
+static void test_minutes_left_warning() {
+  SessionMonitor monitor;
+  monitor.update(true, 70, 180, 3600000, WARN_MS);
+  TEST_ASSERT_EQUAL_HEX32(0, monitor.update(true, 70, 180, WARN_MS + 1, WARN_MS));
+  TEST_ASSERT_EQUAL_HEX32(SESSION_EVENT_MINUTES_LEFT, monitor.update(true, 70, 180, WARN_MS, WARN_MS));
+  TEST_ASSERT_EQUAL_HEX32(0, monitor.update(true, 70, 180, WARN_MS - 1000, WARN_MS));
+
+  // Added time lifts it back above, so it warns again later
+  monitor.update(true, 70, 180, WARN_MS + 60000, WARN_MS);
+  TEST_ASSERT_EQUAL_HEX32(SESSION_EVENT_MINUTES_LEFT, monitor.update(true, 70, 180, WARN_MS, WARN_MS));
+}
+
+static void test_short_session_not_warned_at_start() {
+  SessionMonitor monitor;
+  TEST_ASSERT_EQUAL_HEX32(SESSION_EVENT_ON, monitor.update(true, 70, 180, 5 * 60000UL, WARN_MS));
+  TEST_ASSERT_EQUAL_HEX32(0, monitor.update(true, 70, 180, 4 * 60000UL, WARN_MS));
+}
+
+static void test_warning_off_when_zero() {
+  SessionMonitor monitor;
+  monitor.update(true, 70, 180, 3600000, 0);
+  TEST_ASSERT_EQUAL_HEX32(0, monitor.update(true, 70, 180, 0, 0));
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_on_and_off_edges);
+  RUN_TEST(test_reached_fires_once_per_session);
+  RUN_TEST(test_reached_after_dip_and_recovery);
+  RUN_TEST(test_minutes_left_warning);
+  RUN_TEST(test_short_session_not_warned_at_start);
+  RUN_TEST(test_warning_off_when_zero);
+  return UNITY_END();
+}
@@ -0,0 +1,95 @@
+#include <unity.h>
+#include "thermostat.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void test_full_on_below_band() {
+  Thermostat thermostat;
+  thermostat.setSetpoint(180.0f);
+  thermostat.reset(0);
+  thermostat.update(180.0f - THERMOSTAT_PID_BAND_F - 1, 1000);
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, thermostat.output());
+  TEST_ASSERT_TRUE(thermostat.heaterOn(1000));
+  TEST_ASSERT_EQUAL_UINT32(THERMOSTAT_WINDOW_MS - 1000, thermostat.nextSwitchMs(1000));
+}
+
+static void test_off_above_setpoint() {
+  Thermostat thermostat;
+  thermostat.setSetpoint(180.0f);
+  thermostat.reset(0);
+  thermostat.update(185.0f, 1000);
+  thermostat.update(185.0f, 2000);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, thermostat.output());
+  TEST_ASSERT_FALSE(thermostat.heaterOn(2000));
+}
+
+static void test_duty_becomes_window_fraction() {
+  Thermostat thermostat;
+  thermostat.reset(0);
+  thermostat.setOutput(0.3f);
+  TEST_ASSERT_TRUE(thermostat.heaterOn(2999));
+  TEST_ASSERT_FALSE(thermostat.heaterOn(3000));
+  TEST_ASSERT_EQUAL_UINT32(THERMOSTAT_WINDOW_MS - 3000, thermostat.nextSwitchMs(3000));
+  TEST_ASSERT_TRUE(thermostat.heaterOn(THERMOSTAT_WINDOW_MS + 100));
+}
+
+static void test_slivers_rounded_away() {
+  Thermostat thermostat;
+  thermostat.reset(0);
+  thermostat.setOutput((THERMOSTAT_MIN_PULSE_MS - 1) / (float)THERMOSTAT_WINDOW_MS);
+  TEST_ASSERT_FALSE(thermostat.heaterOn(0));
+  thermostat.setOutput(1.0f - (THERMOSTAT_MIN_PULSE_MS - 1) / (float)THERMOSTAT_WINDOW_MS);
+  TEST_ASSERT_TRUE(thermostat.heaterOn(THERMOSTAT_WINDOW_MS - 1));
+}
+
+static void test_zero_gains_select_hysteresis() {
+  Thermostat thermostat;
+  PidGains none = { 0, 0, 0 };
+  thermostat.setGains(none);
+  TEST_ASSERT_EQUAL(THERMOSTAT_HYSTERESIS, thermostat.getMode());
+
+  thermostat.setSetpoint(180.0f);
+  thermostat.reset(0);
+  thermostat.update(179.0f, 0);                       // Inside the band: stays off
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, thermostat.output());
+  thermostat.update(180.0f - THERMOSTAT_HYSTERESIS_F, 1000);
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, thermostat.output());
+  thermostat.update(179.0f, 2000);                    // Still climbing: stays on
+  TEST_ASSERT_EQUAL_FLOAT(1.0f, thermostat.output());
+  thermostat.update(180.0f, 3000);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, thermostat.output());
+}
+
+static void test_fault_drops_output() {
+  Thermostat thermostat;
+  thermostat.setSetpoint(180.0f);
+  thermostat.reset(0);
+  thermostat.update(100.0f, 0);
+  thermostat.fault();
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, thermostat.output());
+  TEST_ASSERT_FALSE(thermostat.heaterOn(0));
+}
+
+static void test_integral_does_not_wind_up_in_climb() {
+  Thermostat thermostat;
+  thermostat.setSetpoint(180.0f);
+  thermostat.reset(0);
+  for (unsigned long t = 0; t < 3600000UL; t += 1000) {
+    thermostat.update(100.0f, t);   // An hour flat out, far below the band
+  }
+  thermostat.update(180.0f, 3600000UL);
+  TEST_ASSERT_EQUAL_FLOAT(0.0f, thermostat.output());
+}
+
+int main() {
+  UNITY_BEGIN();
+  RUN_TEST(test_full_on_below_band);
+  RUN_TEST(test_off_above_setpoint);
+  RUN_TEST(test_duty_becomes_window_fraction);
+  RUN_TEST(test_slivers_rounded_away);
+  RUN_TEST(test_zero_gains_select_hysteresis);
+  RUN_TEST(test_fault_drops_output);
+  RUN_TEST(test_integral_does_not_wind_up_in_climb);
+  return UNITY_END();
+}